@@ -0,0 +1,517 @@
+// ***************************************************************************************************
+// *  Driver AT não bloqueante para o módulo ESP8266 (modo de múltiplas conexões - MUX)              *
+// *                                                                                                 *
+// *  Os bytes da porta serial são lidos sem espera. Os quadros "+IPD,<id>,<len>:" são copiados      *
+// *  para um buffer circular por conexão e entregues ao tratador da conexão. Os comandos de saída   *
+// *  (CIPSTART, CIPSEND, CIPCLOSE) são executados por uma fila, um de cada vez, sem bloquear o      *
+// *  loop principal. Assim o servidor (ECHO) continua respondendo durante o envio para a ProIoT.    *
+// *                                                                                                 *
+// *  Limitação da SoftwareSerial: não recebe enquanto transmite. O que o módulo envia durante a     *
+// *  escrita dos dados do CIPSEND (~160 ms para o POST a 9600) é perdido. Um quadro +IPD cortado    *
+// *  é descartado e contado em esp_rx_bad, e o parser volta ao modo linha. Com uma serial por       *
+// *  hardware (Serial1 do MEGA) a limitação não existe.                                             *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+// ***************************************************************************************************
+// *  Definições auxiliares                                                                          *
+// ***************************************************************************************************
+#define ESP_RX_BUF      100       // Tamanho do buffer de recepção de cada conexão (bytes, como o buffer[100] anterior)
+#define ESP_JOBS        6         // Tamanho da fila de comandos
+#define ESP_LINE        24        // Tamanho do buffer de linha das respostas do módulo
+#define ESP_IPD_MAX     1460      // Maior quadro +IPD válido (bytes)
+
+// Tipos de comando da fila
+#define ESP_JOB_CMD     1         // Comando AT simples
+#define ESP_JOB_CONNECT 2         // Abre conexão TCP
+#define ESP_JOB_SEND    3         // Envia dados de um buffer da aplicação
+#define ESP_JOB_ECHO    4         // Envia de volta os dados do buffer de recepção da conexão
+#define ESP_JOB_CLOSE   5         // Fecha conexão TCP
+
+// Estados da execução do comando atual
+#define ESP_ST_IDLE     0         // Nenhum comando em execução
+#define ESP_ST_OK       1         // Aguardando "OK"
+#define ESP_ST_PROMPT   2         // Aguardando ">" para enviar os dados
+#define ESP_ST_SEND     3         // Aguardando "SEND OK"
+
+// Tempos máximos de resposta (ms)
+#define ESP_TO_CMD      2000
+#define ESP_TO_CONNECT  10000
+#define ESP_TO_SEND     5000
+#define ESP_TO_IPD      20        // Intervalo sem bytes que corta um quadro +IPD (1 byte a 9600 = ~1 ms)
+
+// ***************************************************************************************************
+// *  Variáveis do driver                                                                            *
+// ***************************************************************************************************
+typedef struct esp_job
+{
+  byte type;                      // Tipo do comando
+  byte link;                      // Conexão (mux_id)
+  const char *data;               // Dados (SEND), host (CONNECT) ou comando (CMD)
+  unsigned int len;               // Tamanho dos dados (SEND/ECHO) ou porta (CONNECT)
+} esp_job;
+
+// Buffers circulares de recepção por conexão
+byte esp_rx[ESP_LINKS][ESP_RX_BUF];
+byte esp_rx_tail[ESP_LINKS];      // Posição de leitura
+byte esp_rx_count[ESP_LINKS];     // Número de bytes no buffer
+byte esp_rx_new;                  // Conexões com quadro novo (1 bit por conexão)
+byte esp_rx_lost[ESP_LINKS];      // Bytes descartados por falta de espaço (por conexão, até esp_lost)
+
+// Parser das respostas do módulo
+char esp_line[ESP_LINE];          // Linha em recepção
+byte esp_line_len;
+byte esp_ipd_link;                // Conexão do quadro +IPD em recepção
+unsigned int esp_ipd_left;        // Bytes restantes do quadro +IPD (0 = modo linha)
+unsigned long esp_ipd_time;       // Recepção do último byte do quadro +IPD (ms)
+
+// Fila de comandos
+esp_job esp_jobs[ESP_JOBS];
+byte esp_job_head;
+byte esp_job_count;
+byte esp_state = ESP_ST_IDLE;
+unsigned long esp_deadline;       // Tempo limite do comando atual
+
+// Tratadores da aplicação
+void (*esp_handler[ESP_LINKS])(byte link);
+void (*esp_event)(byte link, byte event);
+
+// ***************************************************************************************************
+// *  Função: esp_begin                                                                              *
+// *  Descrição: Inicializa o driver. O módulo já deve estar conectado e com MUX habilitado          *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_begin(void){
+  memset(esp_rx_tail, 0, sizeof(esp_rx_tail));
+  memset(esp_rx_count, 0, sizeof(esp_rx_count));
+  memset(esp_rx_lost, 0, sizeof(esp_rx_lost));
+  esp_rx_new = 0;
+  esp_line_len = 0;
+  esp_ipd_left = 0;
+  esp_job_head = 0;
+  esp_job_count = 0;
+  esp_state = ESP_ST_IDLE;
+
+  // Desliga o eco dos comandos para reduzir o tráfego na serial
+  esp_cmd("ATE0");
+}
+
+// ***************************************************************************************************
+// *  Função: esp_on_data / esp_on_event                                                             *
+// *  Descrição: Registra o tratador de dados de uma conexão e o tratador de eventos                 *
+// *  Argumentos: Conexão e função                                                                   *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_on_data(byte link, void (*fn)(byte link)){
+  if (link < ESP_LINKS) esp_handler[link] = fn;
+}
+
+void esp_on_event(void (*fn)(byte link, byte event)){
+  esp_event = fn;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_available / esp_read                                                               *
+// *  Descrição: Consulta e retira bytes do buffer de recepção de uma conexão                        *
+// *  Argumentos: Conexão                                                                            *
+// *  Retorno: Número de bytes disponíveis / próximo byte (-1 se vazio)                              *
+// ***************************************************************************************************
+byte esp_available(byte link){
+  return (link < ESP_LINKS) ? esp_rx_count[link] : 0;
+}
+
+int esp_read(byte link){
+  if (esp_available(link) == 0) return -1;
+  byte c = esp_rx[link][esp_rx_tail[link]];
+  esp_rx_tail[link] = (esp_rx_tail[link] + 1) % ESP_RX_BUF;
+  esp_rx_count[link]--;
+  return c;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_lost                                                                               *
+// *  Descrição: Bytes descartados por falta de espaço no buffer da conexão desde a última chamada   *
+// *  Argumentos: Conexão                                                                            *
+// *  Retorno: Número de bytes descartados (até 255)                                                 *
+// ***************************************************************************************************
+byte esp_lost(byte link){
+  if (link >= ESP_LINKS) return 0;
+  byte n = esp_rx_lost[link];
+  esp_rx_lost[link] = 0;
+  return n;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_flush                                                                              *
+// *  Descrição: Descarta os dados recebidos de uma conexão (fechada ou com falha no envio)          *
+// *  Argumentos: Conexão                                                                            *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_flush(byte link){
+  if (link >= ESP_LINKS) return;
+  esp_rx_tail[link] = 0;
+  esp_rx_count[link] = 0;
+  esp_rx_new &= ~(1 << link);
+}
+
+// ***************************************************************************************************
+// *  Função: esp_deliver                                                                            *
+// *  Descrição: Entrega os dados novos de uma conexão ao seu tratador                               *
+// *  Argumentos: Conexão                                                                            *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_deliver(byte link){
+  if (link >= ESP_LINKS || !(esp_rx_new & (1 << link))) return;
+  esp_rx_new &= ~(1 << link);
+  if (esp_handler[link] != NULL) esp_handler[link](link);
+}
+
+// ***************************************************************************************************
+// *  Função: esp_push                                                                               *
+// *  Descrição: Insere um comando na fila                                                           *
+// *  Argumentos: Tipo, conexão, dados e tamanho                                                     *
+// *  Retorno: true se o comando foi aceito                                                          *
+// ***************************************************************************************************
+bool esp_push(byte type, byte link, const char *data, unsigned int len){
+  if (esp_job_count >= ESP_JOBS) return false;
+  esp_job *j = &esp_jobs[(esp_job_head + esp_job_count) % ESP_JOBS];
+  j->type = type;
+  j->link = link;
+  j->data = data;
+  j->len  = len;
+  esp_job_count++;
+  return true;
+}
+
+// ***************************************************************************************************
+// *  Funções de comando (não bloqueantes)                                                           *
+// *  esp_cmd:     comando AT simples (o texto deve permanecer válido até a execução)                *
+// *  esp_connect: abre conexão TCP com o host (o host deve permanecer válido até a execução)        *
+// *  esp_send:    envia dados (o buffer deve permanecer válido até o evento ESP_EV_SENT/FAIL)       *
+// *  esp_echo:    envia de volta len bytes do buffer de recepção da própria conexão                 *
+// *  esp_close:   fecha a conexão                                                                   *
+// *  Retorno: true se o comando foi aceito na fila                                                  *
+// ***************************************************************************************************
+bool esp_cmd(const char *cmd){
+  return esp_push(ESP_JOB_CMD, 255, cmd, 0);
+}
+
+bool esp_connect(byte link, const char *host, unsigned int port){
+  return esp_push(ESP_JOB_CONNECT, link, host, port);
+}
+
+bool esp_send(byte link, const char *data, unsigned int len){
+  return esp_push(ESP_JOB_SEND, link, data, len);
+}
+
+bool esp_echo(byte link, unsigned int len){
+  return esp_push(ESP_JOB_ECHO, link, NULL, len);
+}
+
+bool esp_close(byte link){
+  return esp_push(ESP_JOB_CLOSE, link, NULL, 0);
+}
+
+// ***************************************************************************************************
+// *  Função: esp_pending                                                                            *
+// *  Descrição: Checa se há comandos na fila (ou em execução) para a conexão                        *
+// *  Argumentos: Conexão                                                                            *
+// *  Retorno: true se há comandos pendentes                                                         *
+// ***************************************************************************************************
+bool esp_pending(byte link){
+  for (byte i=0; i<esp_job_count; i++){
+    if (esp_jobs[(esp_job_head + i) % ESP_JOBS].link == link) return true;
+  }
+  return false;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_free                                                                               *
+// *  Descrição: Lugares livres na fila de comandos                                                  *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Número de comandos que ainda podem ser aceitos                                        *
+// ***************************************************************************************************
+byte esp_free(void){
+  return ESP_JOBS - esp_job_count;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_notify                                                                             *
+// *  Descrição: Repassa um evento de conexão para a aplicação                                       *
+// *  Argumentos: Conexão e evento                                                                   *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_notify(byte link, byte event){
+  if (esp_event != NULL) esp_event(link, event);
+}
+
+// ***************************************************************************************************
+// *  Função: esp_start                                                                              *
+// *  Descrição: Inicia a execução do primeiro comando da fila                                       *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_start(void){
+  esp_job *j = &esp_jobs[esp_job_head];
+  unsigned long timeout = ESP_TO_CMD;
+
+  switch (j->type){
+    case ESP_JOB_CMD:
+      ESP_Serial.println(j->data);
+      esp_state = ESP_ST_OK;
+      break;
+
+    case ESP_JOB_CONNECT:
+      ESP_Serial.print(F("AT+CIPSTART="));
+      ESP_Serial.print(j->link);
+      ESP_Serial.print(F(",\"TCP\",\""));
+      ESP_Serial.print(j->data);
+      ESP_Serial.print(F("\","));
+      ESP_Serial.println(j->len);
+      esp_state = ESP_ST_OK;
+      timeout = ESP_TO_CONNECT;
+      break;
+
+    case ESP_JOB_SEND:
+    case ESP_JOB_ECHO:
+      ESP_Serial.print(F("AT+CIPSEND="));
+      ESP_Serial.print(j->link);
+      ESP_Serial.print(',');
+      ESP_Serial.println(j->len);
+      esp_state = ESP_ST_PROMPT;
+      break;
+
+    case ESP_JOB_CLOSE:
+      ESP_Serial.print(F("AT+CIPCLOSE="));
+      ESP_Serial.println(j->link);
+      esp_state = ESP_ST_OK;
+      break;
+  }
+  esp_deadline = millis() + timeout;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_finish                                                                             *
+// *  Descrição: Finaliza o comando atual e gera o evento correspondente                             *
+// *  Argumentos: true para sucesso                                                                  *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_finish(bool ok){
+  esp_job j = esp_jobs[esp_job_head];
+  esp_job_head = (esp_job_head + 1) % ESP_JOBS;
+  esp_job_count--;
+  esp_state = ESP_ST_IDLE;
+
+  // Falha ao fechar: a conexão já estava fechada
+  if (j.type == ESP_JOB_CLOSE || j.type == ESP_JOB_CMD) return;
+
+  if (ok){
+    if (j.type == ESP_JOB_SEND || j.type == ESP_JOB_ECHO){
+      esp_tx_bytes += j.len;
+      esp_notify(j.link, ESP_EV_SENT);
+    }
+    return;
+  }
+
+  // Em caso de falha, descarta os dados recebidos e os envios pendentes da mesma conexão
+  esp_flush(j.link);
+  byte n = esp_job_count;
+  for (byte i=0; i<n; i++){
+    esp_job k = esp_jobs[esp_job_head];
+    esp_job_head = (esp_job_head + 1) % ESP_JOBS;
+    esp_job_count--;
+    if (k.link != j.link || (k.type != ESP_JOB_SEND && k.type != ESP_JOB_ECHO)){
+      esp_push(k.type, k.link, k.data, k.len);
+    }
+  }
+  esp_notify(j.link, ESP_EV_FAIL);
+}
+
+// ***************************************************************************************************
+// *  Função: esp_ipd_abort                                                                          *
+// *  Descrição: Descarta o quadro +IPD em recepção (bytes perdidos) e volta ao modo linha           *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_ipd_abort(void){
+  esp_rx_bad++;
+  esp_flush(esp_ipd_link);
+  esp_ipd_left = 0;
+  esp_line_len = 0;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_prompt                                                                             *
+// *  Descrição: Envia os dados após o prompt ">" do comando CIPSEND                                 *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_prompt(void){
+  esp_job *j = &esp_jobs[esp_job_head];
+
+  if (j->type == ESP_JOB_SEND){
+    ESP_Serial.write((const uint8_t*)j->data, j->len);
+  } else {
+    for (unsigned int i=0; i<j->len; i++){
+      int c = esp_read(j->link);
+      ESP_Serial.write((byte)(c < 0 ? 0 : c));
+    }
+  }
+
+  // O restante do quadro em recepção chegou durante a escrita e foi perdido
+  if (esp_ipd_left > 0) esp_ipd_abort();
+
+  esp_state = ESP_ST_SEND;
+  esp_deadline = millis() + ESP_TO_SEND;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_line_done                                                                          *
+// *  Descrição: Trata uma linha completa de resposta do módulo                                      *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_line_done(void){
+  // Eventos assíncronos de conexão: "<id>,CONNECT", "<id>,CLOSED"
+  if (esp_line[0] >= '0' && esp_line[0] <= '9' && esp_line[1] == ','){
+    byte link = esp_line[0] - '0';
+    if (strcmp(esp_line + 2, "CONNECT") == 0){
+      // Conexão nova: nada da conexão anterior com o mesmo id
+      esp_flush(link);
+      esp_notify(link, ESP_EV_CONNECT);
+    } else if (strcmp(esp_line + 2, "CLOSED") == 0){
+      // Entrega o que chegou antes do fechamento e descarta o restante
+      esp_deliver(link);
+      esp_flush(link);
+      esp_notify(link, ESP_EV_CLOSED);
+    }
+    return;
+  }
+
+  // Respostas do comando em execução
+  switch (esp_state){
+    case ESP_ST_OK:
+      if (strcmp(esp_line, "OK") == 0 || strcmp(esp_line, "ALREADY CONNECTED") == 0){
+        esp_finish(true);
+      } else if (strcmp(esp_line, "ERROR") == 0 || strcmp(esp_line, "FAIL") == 0){
+        esp_finish(false);
+      }
+      break;
+
+    case ESP_ST_PROMPT:
+      // "OK" antecede o prompt e é ignorado
+      if (strcmp(esp_line, "ERROR") == 0 || strcmp(esp_line, "link is not valid") == 0){
+        esp_finish(false);
+      }
+      break;
+
+    case ESP_ST_SEND:
+      if (strcmp(esp_line, "SEND OK") == 0){
+        esp_finish(true);
+      } else if (strcmp(esp_line, "SEND FAIL") == 0 || strcmp(esp_line, "ERROR") == 0){
+        esp_finish(false);
+      }
+      break;
+  }
+}
+
+// ***************************************************************************************************
+// *  Função: esp_feed                                                                               *
+// *  Descrição: Processa um byte recebido do módulo                                                 *
+// *  Argumentos: Byte recebido                                                                      *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_feed(byte c){
+  // Modo dado: copia o conteúdo do quadro +IPD para o buffer da conexão
+  if (esp_ipd_left > 0){
+    byte link = esp_ipd_link;
+    if (link < ESP_LINKS && esp_rx_count[link] < ESP_RX_BUF){
+      esp_rx[link][(esp_rx_tail[link] + esp_rx_count[link]) % ESP_RX_BUF] = c;
+      esp_rx_count[link]++;
+      esp_rx_bytes++;
+    } else {
+      esp_rx_drop++;
+      if (link < ESP_LINKS && esp_rx_lost[link] < 255) esp_rx_lost[link]++;
+    }
+    if (--esp_ipd_left == 0){
+      esp_rx_new |= (1 << link);
+    }
+    esp_ipd_time = millis();
+    return;
+  }
+
+  // Modo linha
+  if (c == '\r') return;
+  if (c == '\n'){
+    esp_line[esp_line_len] = 0;
+    if (esp_line_len > 0) esp_line_done();
+    esp_line_len = 0;
+    return;
+  }
+
+  // Prompt do CIPSEND (não termina com nova linha)
+  if (c == '>' && esp_line_len == 0 && esp_state == ESP_ST_PROMPT){
+    esp_prompt();
+    return;
+  }
+
+  // Cabeçalho do quadro de dados: "+IPD,<id>,<len>:"
+  if (c == ':' && esp_line_len > 5 && strncmp(esp_line, "+IPD,", 5) == 0){
+    esp_line[esp_line_len] = 0;
+    char *p = strchr(esp_line + 5, ',');
+    int link = atoi(esp_line + 5);
+    long len = (p != NULL) ? atol(p + 1) : 0;
+    esp_line_len = 0;
+
+    // Cabeçalho corrompido: continua no modo linha
+    if (esp_line[5] < '0' || esp_line[5] > '9' || link >= ESP_LINKS || len <= 0 || len > ESP_IPD_MAX){
+      esp_rx_bad++;
+      return;
+    }
+    esp_ipd_link = link;
+    esp_ipd_left = len;
+    esp_ipd_time = millis();
+    return;
+  }
+
+  if (esp_line_len < ESP_LINE - 1) esp_line[esp_line_len++] = c;
+}
+
+// ***************************************************************************************************
+// *  Função: esp_loop                                                                               *
+// *  Descrição: Processa a recepção, os tempos limite, os tratadores e a fila de comandos.          *
+// *             Deve ser chamada continuamente no loop()                                            *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void esp_loop(void){
+  // Lê tudo o que já chegou, sem aguardar
+  while (ESP_Serial.available()){
+    esp_feed(ESP_Serial.read());
+  }
+
+  // Quadro +IPD parado no meio: bytes perdidos
+  if (esp_ipd_left > 0 && millis() - esp_ipd_time > ESP_TO_IPD){
+    esp_ipd_abort();
+  }
+
+  // Tempo limite do comando atual
+  if (esp_state != ESP_ST_IDLE && (long)(millis() - esp_deadline) >= 0){
+    esp_finish(false);
+  }
+
+  // Entrega os quadros recebidos aos tratadores das conexões
+  if (esp_rx_new){
+    for (byte link=0; link<ESP_LINKS; link++){
+      esp_deliver(link);
+    }
+  }
+
+  // Inicia o próximo comando da fila
+  if (esp_state == ESP_ST_IDLE && esp_job_count > 0){
+    esp_start();
+  }
+}
@@ -15,9 +15,24 @@
 // ***************************************************************************************************
 // *  Definições de Operação                                                                         *
 // ***************************************************************************************************
-#define TCP_SERVER    OFF       // Inicia servidor TCP
+#define TCP_SERVER    ON        // Inicia servidor TCP (ECHO)
 #define CLOSE_TCP     ON        // Fecha conexão TCP após retransmissão dos dados (ECHO)
+#define SERVER_PORT   8090      // Porta do servidor TCP (ECHO)
 #define BASE_TIME     15        // Tempo entre transmissões automáticas (s)
+#define STATS_TIME    60        // Tempo entre impressões das estatísticas (s)
+#define UPLINK_TO     10        // Tempo máximo para resposta do envio (s)
+
+// ***************************************************************************************************
+// *  Definições do driver AT (EspAT.ino)                                                            *
+// ***************************************************************************************************
+#define ESP_LINKS     5         // Número de conexões do módulo (mux_id 0 a 4)
+#define ESP_UPLINK    4         // Conexão reservada para o envio à ProIoT (0 a 3 para o servidor)
+
+// Eventos gerados pelo driver
+#define ESP_EV_CONNECT  1       // Conexão aberta
+#define ESP_EV_SENT     2       // Dados enviados (SEND OK)
+#define ESP_EV_CLOSED   3       // Conexão fechada
+#define ESP_EV_FAIL     4       // Falha de comando (conexão, envio ou tempo limite)
 
 // ***************************************************************************************************
 // *  Bibliotecas                                                                                    *
@@ -64,13 +79,32 @@ ESP8266 wifi(ESP_Serial);
 // ***************************************************************************************************
 #include "chaves.h"                  //Comente essa linha se inserir os dados nas linhas superiores
 
-//definição da variável de leitura da resposta do servidor
-String resposta = "";
-
 // ***************************************************************************************************
 // *  Variáveis globais                                                                              *
 // ***************************************************************************************************
-int  base_time = BASE_TIME;   // Contador de tempo para transmissão base de tempo (1 seg)           
+String uplink_req = "";       // Requisição HTTP em envio (deve permanecer válida até SEND OK)
+bool uplink_busy = false;     // Envio em andamento
+bool uplink_resp = false;     // Resposta do servidor recebida
+unsigned long uplink_t0;      // Início do envio (ms)
+
+// ***************************************************************************************************
+// *  Estatísticas de vazão e latência                                                               *
+// ***************************************************************************************************
+unsigned long echo_t0[ESP_LINKS]; // Recepção do quadro em eco por conexão (ms)
+unsigned int  echo_count;     // Quadros respondidos
+unsigned long echo_bytes;     // Bytes respondidos
+unsigned long echo_lat_sum;   // Soma das latências de eco (ms)
+unsigned long echo_lat_max;   // Maior latência de eco (ms)
+unsigned int  uplink_count;   // Envios iniciados
+unsigned int  uplink_ok;      // Envios com resposta do servidor
+unsigned int  uplink_fail;    // Envios com falha
+unsigned long uplink_lat_sum; // Soma das latências até a resposta (ms)
+unsigned long uplink_lat_max; // Maior latência até a resposta (ms)
+unsigned long stats_t0;       // Início da janela das estatísticas (ms)
+unsigned long esp_rx_bytes;   // Bytes recebidos em quadros +IPD (atualizado em EspAT.ino)
+unsigned long esp_tx_bytes;   // Bytes enviados com CIPSEND (atualizado em EspAT.ino)
+unsigned int  esp_rx_drop;    // Bytes descartados por falta de espaço (atualizado em EspAT.ino)
+unsigned int  esp_rx_bad;     // Quadros +IPD corrompidos e descartados (atualizado em EspAT.ino)
 
 // ***************************************************************************************************
 // *  Variáveis do Timer2  (Temporizador)                                                            *
@@ -81,6 +115,7 @@ bool t2_fm;                   // Flag indicando que passou 1 minuto
 bool t2_fh;                   // Flag indicando que passou 1 hora
 byte t2_seg;                  // Contador de segundos
 byte t2_min;                  // Contador de minutos
+volatile unsigned long t2_ms; // Contador de milissegundos (base do agendador de tarefas)
 
 // ***************************************************************************************************
 // *  Função de SETUP do sistema                                                                     *
@@ -90,8 +125,8 @@ void setup(void)
   // Cria uma semente para o gerador de números randômicos
   randomSeed(500);
   //Configura timer2
-  setupTimer2();  
-   
+  setupTimer2();
+
   //Aguarda estabilização do módulo ESP8266
   delay(500);
   
@@ -120,30 +155,39 @@ void setup(void)
       Serial.println("Falha na conexao WiFi.");
   }
   
-  #if (TCP_SERVER==ON)
-    //Habilita a funcionalidade MUX, que permite a realização de várias conexõess TCP/UDP simultâneas
-    if (wifi.enableMUX()) {
-        Serial.println("Multiplas conexoes OK.");
-    } else {
-        Serial.println("Erro ao configurar multiplas conexoes.");
-    }
+  //Habilita a funcionalidade MUX, que permite a realização de várias conexõess TCP/UDP simultâneas
+  //O envio para a ProIoT usa a conexão ESP_UPLINK e o servidor as demais
+  if (wifi.enableMUX()) {
+      Serial.println("Multiplas conexoes OK.");
+  } else {
+      Serial.println("Erro ao configurar multiplas conexoes.");
+  }
 
+  #if (TCP_SERVER==ON)
     //Inicia servidor TCP na porta correta (função "startServer(numero_porta)" serve para UDP!
-    if (wifi.startTCPServer(HOST_PORT)) {
+    if (wifi.startTCPServer(SERVER_PORT)) {
         Serial.print("Servidor TPC iniciado com sucesso na porta: ");
-        Serial.println(HOST_PORT);
+        Serial.println(SERVER_PORT);
     } else {
         Serial.println("Erro ao iniciar servidor.");
     }    
+  #endif
 
-  #else
-    // desabilita funcionalidade MUX
-    if (wifi.disableMUX()) {
-        Serial.println("Multiplas conexoes desabilitadas.");
-    } else {
-        Serial.println("Erro ao desabilitar multiplas conexoes.");
+  // A partir daqui a serial do módulo é tratada pelo driver não bloqueante (EspAT.ino)
+  esp_begin();
+  esp_on_event(esp_events);
+  esp_on_data(ESP_UPLINK, uplink_data);
+  #if (TCP_SERVER==ON)
+    for (byte link=0; link<ESP_LINKS; link++){
+      if (link != ESP_UPLINK) esp_on_data(link, echo_data);
     }
   #endif
+
+  // Agenda a transmissão automática, a indicação de funcionamento e as estatísticas
+  t2_every(task_send, BASE_TIME * 1000UL, 0);
+  t2_every(task_alive, 1000UL, 0);
+  t2_every(task_stats, STATS_TIME * 1000UL, 0);
+  stats_t0 = millis();
   
   Serial.println("Setup finalizado!");
   Serial.println("***********************************");
@@ -156,159 +200,252 @@ void setup(void)
 // ***************************************************************************************************
 //Na conexão TCP, basicamente a funcionalidade a ser mostrada será a de "echo", ou seja,
 //a aplicação irá retornar todos os dados enviados para ela via socket TCP.
+//O driver AT e o agendador não bloqueiam, então o eco continua durante os envios para a ProIoT.
 
 void loop(void)
 {
-    //Caso o servidor TCP esteja habilitado, precisa monitorar a recepção de dados
-    #if (TCP_SERVER==ON)
-      //Variável para buffer de dados de recepção/trasmissão
-      uint8_t buf[100] = {0};
-    
-      //Cada conexão TCP tem sua ID, e precisa ser armazenada para referência no programa. 
-      //Usamos essa variavel para isso.
-      uint8_t mux_id;
-  
-      //A variável len serve para armazenar o comprimento de dados recebidos por meio da rotina wifi.recv(), 
-      //que também associa ao buffer os dados recebidos e ao mux_id a id responsável pela transmissão
-      uint32_t len = wifi.recv(&mux_id, buf, sizeof(buf), 100);
-      
-      //Caso tenha recebido algum dado
-      if (len > 0) {
-          //Mostra no terminal (DEBUG) o dado recebido
-          Serial.print(F("Status:["));
-          Serial.print(wifi.getIPStatus().c_str());
-          Serial.println(F("]"));
-          
-          Serial.print(F("Recebido de :"));
-          Serial.print(mux_id);
-          Serial.print("[");
-          for(uint32_t i = 0; i < len; i++) {
-              Serial.print((char)buf[i]);
-          }
-          Serial.print(F("]\r\n"));
-          
-          //Envia o mesmo dado de volta para quem abriu a conexão TCP.
-          //A referência para o socket TCP criado é o mux_id, ou id da conexão, usado na rotina wifi.send
-          if(wifi.send(mux_id, buf, len)) {
-              Serial.println(F("Enviado de volta..."));
-          } else {
-              Serial.println(F("Erro ao enviar de volta"));
-          }
-  
-          #if (CLOSE_TPC==ON)
-            //Liberação da conexão TCP, de modo a permitir que conexões diferentes sejam realizadas.
-            if (wifi.releaseTCP(mux_id)) {
-                Serial.print(F("Liberando conexao TCP com ID: "));
-                Serial.print(mux_id);
-                Serial.println(" OK");
-            } else {
-                Serial.print(F("Erro ao liberar TCP com ID: "));
-                Serial.print(mux_id);
-            }
-            //Finaliza mostrando o Status de liberação [4]
-            Serial.print(F("Status:["));
-            Serial.print(wifi.getIPStatus().c_str());
-            Serial.println(F("]"));
-          #else
-            Serial.println(F("***********************************"));
-            Serial.println(F("Aguardando nova recepção de dados"));
-          #endif
+  // Recepção, fila de comandos e tratadores do ESP8266
+  esp_loop();
+
+  // Executa as tarefas com prazo vencido (base de tempo ajustada pelo Timer2)
+  t2_run();
+}
+
+// ***************************************************************************************************
+// *  Tratador de dados das conexões do servidor (ECHO)                                              *
+// ***************************************************************************************************
+void echo_data(byte link)
+{
+  // Um eco por vez em cada conexão; o restante é enviado após o SEND OK
+  if (esp_pending(link)) return;
+
+  byte len = esp_available(link);
+  if (len == 0) return;
+
+  Serial.print(F("Recebido de :"));
+  Serial.print(link);
+  Serial.print(F(" ["));
+  Serial.print(len);
+  Serial.println(F(" bytes]"));
+
+  // Quadro maior que o buffer da conexão
+  byte lost = esp_lost(link);
+  if (lost > 0) {
+    Serial.print(F("Descartados (buffer cheio): "));
+    Serial.println(lost);
+  }
+
+  //Envia o mesmo dado de volta para quem abriu a conexão TCP.
+  echo_t0[link] = millis();
+  if (!esp_echo(link, len)) {
+      Serial.println(F("Erro ao enviar de volta"));
+  }
+}
+
+// ***************************************************************************************************
+// *  Tratador de dados da conexão de envio (resposta da ProIoT)                                     *
+// ***************************************************************************************************
+void uplink_data(byte link)
+{
+  // Primeira parte da resposta: registra a latência e libera a conexão
+  if (uplink_busy && !uplink_resp) {
+    unsigned long lat = millis() - uplink_t0;
+    uplink_resp = true;
+    uplink_lat_sum += lat;
+    if (lat > uplink_lat_max) uplink_lat_max = lat;
+    Serial.print(F("Recebido retorno em "));
+    Serial.print(lat);
+    Serial.println(F(" ms:"));
+    esp_close(link);
+  }
+
+  // Imprime e descarta a resposta
+  int c;
+  while ((c = esp_read(link)) >= 0) {
+    Serial.print((char)c);
+  }
+  Serial.print(F("\r\n"));
+}
+
+// ***************************************************************************************************
+// *  Tratador de eventos do driver AT                                                               *
+// ***************************************************************************************************
+void esp_events(byte link, byte event)
+{
+  if (link == ESP_UPLINK) {
+    switch (event) {
+      case ESP_EV_FAIL:
+        Serial.println(F("Erro no envio para a ProIoT."));
+        uplink_end(false);
+        esp_close(link);
+        break;
+      case ESP_EV_CLOSED:
+        uplink_end(uplink_resp);
+        break;
     }
+    return;
+  }
 
-  #else
-  
-    // Base de tempo ajustada
-    // Checa temporizador para 1 segundo
-    if(t2_fs){
-      // Limpa flag de segundos
-      t2_fs=false;
-
-      // Checa inicio d base de tempo
-      if (base_time==BASE_TIME){
-        Serial.print(F("Aguarda "));
-        Serial.print(BASE_TIME);
-        Serial.print("s:");
-      } else {
-        // Immprime "." para mostrar que esta rodando
-        Serial.print(F("."));
-      }
-      
-      //Checa término da base de tempo
-      if (base_time==0){        
-        base_time = BASE_TIME;   // Reinicia base de tempo
-        Serial.println(F("."));
-        send_data();             // Executa comandos da base de tempo
-      } else {
-        base_time--;             // Decrementa contador de tem
+  switch (event) {
+    case ESP_EV_SENT:
+      {
+        unsigned long lat = millis() - echo_t0[link];
+        echo_count++;
+        echo_lat_sum += lat;
+        if (lat > echo_lat_max) echo_lat_max = lat;
+        Serial.println(F("Enviado de volta..."));
       }
-    }
-    
-  #endif
+      #if (CLOSE_TCP==ON)
+        //Liberação da conexão TCP, de modo a permitir que conexões diferentes sejam realizadas.
+        esp_close(link);
+      #else
+        // Dados que chegaram durante o eco
+        echo_data(link);
+      #endif
+      break;
+    case ESP_EV_FAIL:
+      Serial.print(F("Erro ao enviar de volta para ID: "));
+      Serial.println(link);
+      break;
+    case ESP_EV_CLOSED:
+      Serial.print(F("Conexao TCP fechada com ID: "));
+      Serial.println(link);
+      break;
+  }
+}
+
+// ***************************************************************************************************
+// *  Finaliza o envio para a ProIoT                                                                 *
+// ***************************************************************************************************
+void uplink_end(bool ok)
+{
+  if (!uplink_busy) return;
+  uplink_busy = false;
+  if (ok) {
+    uplink_ok++;
+  } else {
+    uplink_fail++;
+  }
+}
+
+// ***************************************************************************************************
+// *  Tarefa de transmissão automática (a cada BASE_TIME segundos)                                   *
+// ***************************************************************************************************
+void task_send(void)
+{
+  Serial.println(F("."));
+  send_data();                   // Executa comandos da base de tempo
+  Serial.print(F("Aguarda "));
+  Serial.print(BASE_TIME);
+  Serial.print("s:");
+}
+
+// ***************************************************************************************************
+// *  Tarefa de indicação de funcionamento (a cada 1 segundo)                                        *
+// ***************************************************************************************************
+void task_alive(void)
+{
+  // Tempo limite para a resposta do envio
+  if (uplink_busy && millis() - uplink_t0 > UPLINK_TO * 1000UL) {
+    Serial.println(F("Não recebido retorno."));
+    uplink_end(false);
+    esp_close(ESP_UPLINK);
+  }
+
+  // Immprime "." para mostrar que esta rodando
+  Serial.print(F("."));
+}
+
+// ***************************************************************************************************
+// *  Tarefa de impressão das estatísticas (a cada STATS_TIME segundos)                              *
+// ***************************************************************************************************
+void task_stats(void)
+{
+  unsigned long window = (millis() - stats_t0) / 1000;
+  if (window == 0) window = 1;
+
+  Serial.println();
+  Serial.print(F("ECHO: "));
+  Serial.print(echo_count);
+  Serial.print(F(" quadros, "));
+  Serial.print(esp_tx_bytes / window);
+  Serial.print(F(" B/s tx, "));
+  Serial.print(esp_rx_bytes / window);
+  Serial.print(F(" B/s rx, latencia media "));
+  Serial.print(echo_count ? echo_lat_sum / echo_count : 0);
+  Serial.print(F(" ms, max "));
+  Serial.print(echo_lat_max);
+  Serial.print(F(" ms, descartados "));
+  Serial.print(esp_rx_drop);
+  Serial.print(F(" B, corrompidos "));
+  Serial.println(esp_rx_bad);
+
+  Serial.print(F("ENVIO: "));
+  Serial.print(uplink_count);
+  Serial.print(F(" iniciados, "));
+  Serial.print(uplink_ok);
+  Serial.print(F(" ok, "));
+  Serial.print(uplink_fail);
+  Serial.print(F(" falhas, latencia media "));
+  Serial.print(uplink_ok ? uplink_lat_sum / uplink_ok : 0);
+  Serial.print(F(" ms, max "));
+  Serial.print(uplink_lat_max);
+  Serial.println(F(" ms"));
+
+  t2_print_stats();
+
+  // Reinicia a janela das estatísticas
+  echo_count = 0; echo_lat_sum = 0; echo_lat_max = 0;
+  uplink_count = 0; uplink_ok = 0; uplink_fail = 0; uplink_lat_sum = 0; uplink_lat_max = 0;
+  esp_tx_bytes = 0; esp_rx_bytes = 0;
+  stats_t0 = millis();
 }
 
 // ***************************************************************************************************
 // *  Função de envio de dados TCP                                                                   *
 // ***************************************************************************************************
+// Apenas prepara a requisição e coloca os comandos na fila do driver; a resposta é tratada em
+// uplink_data() e o resultado em esp_events()
 void send_data(void)
 {
-  //Variável para buffer de dados de recepção/trasmissão
-  uint8_t buffer[300] = {0};
+  // Envio anterior ainda em andamento (ou com comandos na fila após o tempo limite):
+  // o SEND na fila ainda aponta para uplink_req
+  if (uplink_busy || esp_pending(ESP_UPLINK)) {
+      Serial.println(F("Envio anterior em andamento."));
+      return;
+  }
 
   // Cria número randômico
   float value = random(VAL_MIN, VAL_MAX)*VAL_FAC;
-     
-  //Cria conexão TCP
-  if (wifi.createTCP(HOST_NAME, HOST_PORT)) {
-      Serial.print(F("Conexão TCP criada com sucesso na porta "));
-      Serial.print(HOST_PORT);
-      Serial.println(F("."));
-  } else {
-      Serial.println(F("Erro ao criar conexão TCP."));
-  }
   
   //Preparação do pacote de dados
-  String dados = "POST ";
-  dados += "/stream/device/";
-  dados += NODE;
-  dados += "/variable/";
-  dados += ALIAS;
-  dados += "/";
-  dados += value;
-  dados += " HTTP/1.1\r\n";
-  dados += "Host: ";
-  dados += HOST_NAME;
-  dados += "\r\n";
-  dados += "Authorization: ";
-  dados += TOKEN;
-  dados += "\r\n";
-  //dados += "Connection: Keep-Alive\r\n"; //mantem a conexão ativa para o envio do segundo header
-  dados += "\r\n\r\n";
-  
-  //Envio do pacote de dados
-  Serial.println(F("Enviando pacote de dados..."));
-  Serial.print(dados);
-  wifi.send((const uint8_t*)dados.c_str(), dados.length());
-  
-  //Recepção da resposta de retorno
-  uint32_t len = wifi.recv(buffer, sizeof(buffer), 10000);
-  if (len > 0) {
-      Serial.println(F("Recebido retorno:"));
-      for(uint32_t i = 0; i < len; i++) {
-          Serial.print((char)buffer[i]);
-      }
-      Serial.print(F("\r\n"));
-  }
-  else{
-    Serial.println(F("Não recebido retorno."));
-  }
-
-  delay(1000);
+  uplink_req = "POST ";
+  uplink_req += "/stream/device/";
+  uplink_req += NODE;
+  uplink_req += "/variable/";
+  uplink_req += ALIAS;
+  uplink_req += "/";
+  uplink_req += value;
+  uplink_req += " HTTP/1.1\r\n";
+  uplink_req += "Host: ";
+  uplink_req += HOST_NAME;
+  uplink_req += "\r\n";
+  uplink_req += "Authorization: ";
+  uplink_req += TOKEN;
+  uplink_req += "\r\n";
+  uplink_req += "\r\n\r\n";
 
-  //Liberação da conexão TCP
-  if (wifi.releaseTCP()) {
-      Serial.println(F("Conexao TCP liberada com sucesso."));
+  //Cria conexão TCP e envia o pacote de dados (os dois comandos ou nenhum)
+  Serial.println(F("Enviando pacote de dados..."));
+  Serial.print(uplink_req);
+  if (esp_free() >= 2) {
+      esp_connect(ESP_UPLINK, HOST_NAME, HOST_PORT);
+      esp_send(ESP_UPLINK, uplink_req.c_str(), uplink_req.length());
+      uplink_busy = true;
+      uplink_resp = false;
+      uplink_t0 = millis();
+      uplink_count++;
   } else {
-      Serial.println(F("Erro ao liberar conexao TCP."));
+      Serial.println(F("Fila de comandos do ESP8266 cheia."));
   }
-
 }
@@ -9,6 +9,32 @@
 // ***************************************************************************************************
 // *  Definições auxiliares                                                                          *
 // ***************************************************************************************************
+#define T2_TICK_MS      8         // Período de estouro do Timer2 (ms)
+#define T2_MAX_TASKS    6         // Número máximo de tarefas do agendador
+#define T2_NO_TASK      255       // Retorno quando não há espaço para nova tarefa
+#define T2_ONCE         T2_MAX_TASKS  // Posição extra com as estatísticas somadas das execuções únicas
+
+// ***************************************************************************************************
+// *  Tabela de tarefas do agendador                                                                 *
+// ***************************************************************************************************
+// Os prazos são mantidos em milissegundos e o próximo prazo é sempre somado ao anterior, de modo
+// que o período médio não acumula erro (jitter máximo de 1 tick = 8ms)
+typedef struct t2_task
+{
+  void (*fn)(void);               // Função da tarefa (NULL = posição livre)
+  unsigned long period;           // Período (ms), 0 = execução única
+  unsigned long next;             // Próximo prazo de execução (ms)
+  byte catchup;                   // Número máximo de execuções atrasadas recuperadas em sequência
+  unsigned int runs;              // Número de execuções
+  unsigned int overruns;          // Número de prazos perdidos: cada execução atrasada de um período ou
+                                  // mais e cada prazo descartado sem execução (atraso / período)
+  unsigned long exec_last;        // Tempo da última execução (us)
+  unsigned long exec_max;         // Maior tempo de execução (us)
+  unsigned long exec_sum;         // Soma dos tempos de execução (us)
+} t2_task;
+// A posição de uma execução única é liberada antes da execução (pode ser reutilizada pela própria
+// tarefa): o tempo dessas execuções é somado na posição T2_ONCE
+t2_task t2_tasks[T2_MAX_TASKS + 1];
 
 // ***************************************************************************************************
 // *  Função: ISR(TIMER_OVF_vect)                                                                    *
@@ -19,22 +45,25 @@
 ISR(TIMER2_OVF_vect){
   TCNT2 = 131;            // Reinicializa do contador. Estoura em 256 (256-131 = 125)
 
+  // Base de tempo do agendador
+  t2_ms += T2_TICK_MS;    // Incrementa contador de milissegundos
+
   // Decrementa prescaler de timer2
   // Se acabou, passou 1 segundo
   // Os flags devem ser limpos manualmente na rotina principal
 
   if (!(t2_ps--)) {       // Passou 1 segundo
-    t2_ps=125;            // Reinicia 2º prescaler
+    t2_ps=124;            // Reinicia 2º prescaler (125 ticks, de 124 a 0)
     t2_fs=true;           // Marca flag de 1 segundo
     t2_seg++;             // Incrementa contador de segundos
     if (t2_seg==60){      // Passou 1 minuto
-      t2_seg==0;          // Reinicia contador de segundos
+      t2_seg=0;           // Reinicia contador de segundos
       t2_fm=true;         // Marca flag de 1 minuto
       t2_min++;           // Incrementa contador de minutos
-      if (t2_min==60){    // Passou 1 minuto
-        t2_min==0;        // Reinicia contador de minutos
+      if (t2_min==60){    // Passou 1 hora
+        t2_min=0;         // Reinicia contador de minutos
         t2_fh=true;       // Marca flag de 1 hora
-      }    
+      }
     }
   }
 }
@@ -51,9 +80,163 @@ void setupTimer2(void){
   // ciclo_máquina = 1/Fosc = 1/16E6 = 62,5ns = 62,5E-9s
   // Estouro = (125 = 256 - 131) x 1024 x 62,5E-9s = 8ms
   // 2º prescaler t2_ps = 125 x 8ms = 1 segundo
-  
+
   TCCR2B = 0x07;          // Prescaler 1:1024 (ciclo_máquina x 1024)
   TCNT2  = 131;           // Inicializa contador (256 - 131 = 125)
   TIMSK2 = 0x01;          // Interrupção por estouro de timer
-  TCCR2A = 0x00;          // Timer operando em modo normal 
+  TCCR2A = 0x00;          // Timer operando em modo normal
+}
+
+// ***************************************************************************************************
+// *  Função: t2_millis                                                                              *
+// *  Descrição: Lê de forma atômica o contador de milissegundos do Timer2                           *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Tempo desde a inicialização do Timer2 (ms, resolução de 8ms)                          *
+// ***************************************************************************************************
+unsigned long t2_millis(void){
+  unsigned long ms;
+  byte sreg = SREG;       // Salva estado das interrupções
+  cli();                  // Leitura de 32 bits não é atômica no AVR
+  ms = t2_ms;
+  SREG = sreg;            // Restaura estado das interrupções
+  return ms;
+}
+
+// ***************************************************************************************************
+// *  Função: t2_add                                                                                 *
+// *  Descrição: Insere uma tarefa na tabela do agendador                                            *
+// *  Argumentos: Função, primeiro prazo (ms), período (ms, 0 = única) e recuperação de atrasos      *
+// *  Retorno: Identificador da tarefa ou T2_NO_TASK se a tabela estiver cheia                       *
+// ***************************************************************************************************
+byte t2_add(void (*fn)(void), unsigned long delay_ms, unsigned long period_ms, byte catchup){
+  for (byte i=0; i<T2_MAX_TASKS; i++){
+    if (t2_tasks[i].fn == NULL){
+      memset(&t2_tasks[i], 0, sizeof(t2_task));
+      t2_tasks[i].period  = period_ms;
+      t2_tasks[i].next    = t2_millis() + delay_ms;
+      t2_tasks[i].catchup = catchup;
+      t2_tasks[i].fn      = fn;       // Ativa a tarefa por último
+      return i;
+    }
+  }
+  return T2_NO_TASK;
+}
+
+// ***************************************************************************************************
+// *  Função: t2_every                                                                               *
+// *  Descrição: Agenda uma tarefa periódica                                                         *
+// *  Argumentos: Função, período (ms) e número máximo de execuções atrasadas recuperadas            *
+// *              (0 = prazos perdidos são descartados e a fase é reiniciada)                        *
+// *  Retorno: Identificador da tarefa ou T2_NO_TASK                                                 *
+// ***************************************************************************************************
+byte t2_every(void (*fn)(void), unsigned long period_ms, byte catchup){
+  if (period_ms == 0) return T2_NO_TASK;
+  return t2_add(fn, period_ms, period_ms, catchup);
+}
+
+// ***************************************************************************************************
+// *  Função: t2_after                                                                               *
+// *  Descrição: Agenda uma tarefa de execução única                                                 *
+// *  Argumentos: Função e atraso até a execução (ms)                                                *
+// *  Retorno: Identificador da tarefa ou T2_NO_TASK                                                 *
+// ***************************************************************************************************
+byte t2_after(void (*fn)(void), unsigned long delay_ms){
+  return t2_add(fn, delay_ms, 0, 0);
+}
+
+// ***************************************************************************************************
+// *  Função: t2_cancel                                                                              *
+// *  Descrição: Remove uma tarefa do agendador                                                      *
+// *  Argumentos: Identificador da tarefa                                                            *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void t2_cancel(byte id){
+  if (id < T2_MAX_TASKS) t2_tasks[id].fn = NULL;
+}
+
+// ***************************************************************************************************
+// *  Função: t2_run                                                                                 *
+// *  Descrição: Executa as tarefas com prazo vencido. Deve ser chamada continuamente no loop()      *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void t2_run(void){
+  for (byte i=0; i<T2_MAX_TASKS; i++){
+    t2_task *t = &t2_tasks[i];
+    if (t->fn == NULL) continue;
+
+    // Checa prazo (comparação com sinal para suportar o estouro do contador)
+    unsigned long now = t2_millis();
+    if ((long)(now - t->next) < 0) continue;
+
+    // Prazo perdido: atraso maior ou igual a um período
+    if (t->period != 0 && (now - t->next) >= t->period){
+      unsigned long missed = (now - t->next) / t->period;
+      if (missed > t->catchup){
+        // Atraso maior que a recuperação permitida: os prazos vencidos são descartados
+        // e a fase é reiniciada
+        t->overruns = (missed < 0xFFFFUL - t->overruns) ? t->overruns + missed : 0xFFFF;
+        t->next = now;
+      } else if (t->overruns < 0xFFFF){
+        // Execução recuperada: o prazo desta execução foi perdido
+        t->overruns++;
+      }
+    }
+
+    // Execução única libera a posição antes de executar (a tarefa pode se reagendar)
+    void (*fn)(void) = t->fn;
+    if (t->period == 0){
+      t->fn = NULL;
+      t2_exec(T2_ONCE, fn);
+      continue;
+    }
+
+    // Executa a tarefa periódica
+    t->next += t->period;             // Próximo prazo sem acumular erro
+    t2_exec(i, fn);
+  }
+}
+
+// ***************************************************************************************************
+// *  Função: t2_exec                                                                                *
+// *  Descrição: Executa uma tarefa medindo o tempo de execução                                      *
+// *  Argumentos: Posição das estatísticas a atualizar e função da tarefa                            *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void t2_exec(byte id, void (*fn)(void)){
+  t2_task *s = &t2_tasks[id];
+  unsigned long start = micros();
+  fn();
+  s->exec_last = micros() - start;
+  s->runs++;
+  s->exec_sum += s->exec_last;
+  if (s->exec_last > s->exec_max) s->exec_max = s->exec_last;
+}
+
+// ***************************************************************************************************
+// *  Função: t2_print_stats                                                                         *
+// *  Descrição: Imprime na porta DEBUG as estatísticas das tarefas agendadas                        *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void t2_print_stats(void){
+  Serial.println(F("Tarefa\tPeriodo\tExec\tPerdas\tUlt(us)\tMax(us)\tMed(us)"));
+  for (byte i=0; i<=T2_ONCE; i++){
+    t2_task *t = &t2_tasks[i];
+    // Última linha (U): execuções únicas
+    if (i == T2_ONCE){
+      if (t->runs == 0) continue;
+      Serial.print('U');
+    } else {
+      if (t->fn == NULL) continue;
+      Serial.print(i);
+    }
+    Serial.print('\t');
+    Serial.print(t->period);          Serial.print('\t');
+    Serial.print(t->runs);            Serial.print('\t');
+    Serial.print(t->overruns);        Serial.print('\t');
+    Serial.print(t->exec_last);       Serial.print('\t');
+    Serial.print(t->exec_max);        Serial.print('\t');
+    Serial.println(t->runs ? t->exec_sum / t->runs : 0);
+  }
 }
@@ -51,6 +51,14 @@
 #define TEMP2         OFF       // Origem da temperatura 2 (RAND. LM35, DHT11, DHT22, OFF)
 #define TEMP2_ALIAS   "03"      // Alias da temperatura 2
 
+// ***************************************************************************************************
+// *  Envio em lote (todas as leituras acumuladas em um único pacote)                                *
+// ***************************************************************************************************
+#define BATCH         OFF       // Acumula as leituras e envia em um pacote delta-codificado (SampleBatch)
+#define BATCH_ALIAS   "10"      // Alias da variável que recebe o pacote (texto hexadecimal)
+#define BATCH_SIZE    8         // Número de leituras guardadas por variável
+#define BATCH_MAX     48        // Tamanho máximo do pacote (bytes)
+
 // ***************************************************************************************************
 // *  Bibliotecas e includes                                                                         *
 // ***************************************************************************************************
@@ -58,6 +66,9 @@
   #include <avr/wdt.h>
 #endif
 
+#include <FixedPoint.h>         // Conversão e texto dos valores em ponto fixo (sem float)
+#include <FreeRam.h>            // RAM livre entre heap e pilha (atual e mínima desde o reset)
+
 #if (USE_ESP == ON)
   #include "SoftwareSerial.h"
   #define ESP8266_USE_SOFTWARE_SERIAL // Define necessário para que a biblioteca ESP8266 funcione com Software Serial
@@ -115,18 +126,31 @@
 // ***************************************************************************************************
 // *  Variáveis globais                                                                              *
 // ***************************************************************************************************
-int  base_time_send = BASE_TIME_SEND;   // Contador de tempo para transmissão base de tempo (1 seg)
-int  base_time_sensor = BASE_TIME_SENSOR;   // Contador de tempo para transmissão base de tempo (1 seg)
-
-float temperature = 0;        // Valor da temperatura
-float humidity = 0;           // valor da umidade
-float temperature2 = 0;       // Valor da temperatura 2
+int temperature = 0;          // Valor da temperatura (centésimos de °C)
+int humidity = 0;             // valor da umidade (centésimos de %)
+int temperature2 = 0;         // Valor da temperatura 2 (centésimos de °C)
 
 int num_var = 3;
 
 #define VAL_MIN   (0)        // valor minimo para o gerador randômico
 #define VAL_MAX   (40)       // valor máximo para o gerador randômico
 #define VAL_FAC   (1)        // valor do fator multiplicado
+// Fator x 10000 calculado na compilação: o valor aleatório em centésimos é arredondado com
+// inteiros (VAL_FAC fracionário não é truncado e não liga o float)
+#define VAL_FAC_10K ((long)((VAL_FAC) * 10000 + ((VAL_FAC) < 0 ? -0.5 : 0.5)))
+
+// ***************************************************************************************************
+// *  Acumuladores das leituras para envio em lote                                                   *
+// ***************************************************************************************************
+#if (BATCH == ON)
+  #include <SampleBatch.h>
+  sb_sample temp_buf[BATCH_SIZE];
+  sb_sample humi_buf[BATCH_SIZE];
+  sb_sample temp2_buf[BATCH_SIZE];
+  SampleRing temp_ring(1, 1, temp_buf, BATCH_SIZE);     // Id 1 (alias 01), 1 casa decimal
+  SampleRing humi_ring(2, 1, humi_buf, BATCH_SIZE);     // Id 2 (alias 02), 1 casa decimal
+  SampleRing temp2_ring(3, 1, temp2_buf, BATCH_SIZE);   // Id 3 (alias 03), 1 casa decimal
+#endif
 
 // ***************************************************************************************************
 // *  Variáveis do Timer2  (Temporizador)                                                            *
@@ -137,6 +161,7 @@ bool t2_fm;                   // Flag indicando que passou 1 minuto
 bool t2_fh;                   // Flag indicando que passou 1 hora
 byte t2_seg;                  // Contador de segundos
 byte t2_min;                  // Contador de minutos
+volatile unsigned long t2_ms; // Contador de milissegundos (base do agendador de tarefas)
 
 // ***************************************************************************************************
 // *  Estrutura de dados para informações dos sensores                                               *
@@ -144,7 +169,7 @@ byte t2_min;                  // Contador de minutos
 typedef struct data_var
 {
   String Alias;
-  float valor;            //A variável value já existe, para não causar confusão, foi usado em pt-br valor
+  int valor;              //A variável value já existe, para não causar confusão, foi usado em pt-br valor (centésimos)
   int sensor;
 } data_var;
 data_var var[3];
@@ -165,6 +190,13 @@ void setup(void)
   //Configura timer2
   setupTimer2();
 
+  // Agenda as tarefas periódicas (leitura dos sensores e envio dos dados)
+  t2_every(task_sensors, BASE_TIME_SENSOR * 1000UL, 0);
+  t2_every(task_send, BASE_TIME_SEND * 1000UL, 0);
+  #if (DEBUG == ON)
+    t2_every(task_alive, 1000UL, 0);
+  #endif
+
   //Inicializa porta serial do DEBUG
   Serial.begin(9600);
 
@@ -179,21 +211,14 @@ void setup(void)
     reset_esp();
   #endif
 
-  #if (USE_LM35 == ON)
-    // Acerta pinagem para sensor LM25
-    pinMode(PIN_LM35, INPUT); 
-  #endif
-
-  #if (USE_DHT11 == ON || USE_DHT22 == ON)
-    // Acerta pinagem para sensor DHT
-    pinMode(PIN_DHT, INPUT_PULLUP); 
-  #endif            
+  // Inicializa os sensores (Sensores.ino)
+  setup_sensors();
 }
 
 // ***************************************************************************************************
 // *  LOOP principal                                                                                 *
 // ***************************************************************************************************
-// Quando a base de tempo é atingida, lê sensores e envia os dados
+// As tarefas de leitura e envio são executadas pelo agendador do Timer2, cada uma na sua base de tempo
 void loop(void)
 {
   #if (USE_WDT == ON)
@@ -201,62 +226,61 @@ void loop(void)
     wdt_reset();
   #endif
 
-  // Base de tempo ajustada
-  // Checa temporizador para 1 segundo
-  if (t2_fs) {
-    // Limpa flag de segundos
-    t2_fs = false;
+  // Executa as tarefas com prazo vencido
+  t2_run();
+}
 
-    // Checa inicio da base de tempo
-    if (base_time_send == BASE_TIME_SEND) {
-      #if (DEBUG == ON)
-        Serial.print(F("Aguarda "));
-        Serial.print(BASE_TIME_SEND);
-        Serial.print("s:");
-     #endif
-    } else {
-      // Immprime "." para mostrar que esta rodando
-      #if (DEBUG == ON)
-        Serial.print((base_time_send));
-        Serial.print(F("."));
-      #endif
-    }
-    
-    if (base_time_sensor == 0)
-    {
-      base_time_sensor = BASE_TIME_SENSOR-1;  // Reinicia base de tempo
+// ***************************************************************************************************
+// *  Tarefa de leitura dos sensores (a cada BASE_TIME_SENSOR segundos)                              *
+// ***************************************************************************************************
+void task_sensors(void)
+{
+  // Leitura dos sensores
+  #if (DEBUG == ON)
+    Serial.println("\n\rLendo sensores");
+  #endif
+  read_sensors();
+
+  #if (BATCH == ON)
+    // Guarda as leituras com o horário (s) para o próximo envio
+    unsigned long now = t2_millis() / 1000;
+    if (TEMP != OFF)  temp_ring.addRaw(FixedPoint::rescale(temperature, 2, 1), now);
+    if (HUMI != OFF)  humi_ring.addRaw(FixedPoint::rescale(humidity, 2, 1), now);
+    if (TEMP2 != OFF) temp2_ring.addRaw(FixedPoint::rescale(temperature2, 2, 1), now);
+  #endif
+}
 
-            // *********** Comando repetidos na base de tempo *************
-            
-      // Leitura dos sensores
-      #if (DEBUG == ON)
-        Serial.println("\n\rLendo sensores");
-      #endif
-      read_sensors();
-    }
-    else
-    {
-      base_time_sensor--;
-    }
-    
-    //Checa término da base de tempo
-    if (base_time_send == 0) {
-      base_time_send = BASE_TIME_SEND;   // Reinicia base de tempo
-      base_time_sensor = BASE_TIME_SENSOR;  // Reinicia base de tempo
-
-      // *********** Comando repetidos na base de tempo *************
-   
-      // Transmissão dos dados
-      send_data();
-
-      // ************************************************************
-      
-    } else {
-      base_time_send--;             // Decrementa contador de tempo
-    }
-  }
+// ***************************************************************************************************
+// *  Tarefa de envio dos dados (a cada BASE_TIME_SEND segundos)                                     *
+// ***************************************************************************************************
+void task_send(void)
+{
+  // Transmissão dos dados
+  send_data();
+
+  #if (DEBUG == ON)
+    // Estatísticas das tarefas
+    t2_print_stats();
+    // Menor RAM livre desde o reset: margem real da pilha + heap (Strings do envio)
+    Serial.print(F("RAM livre: ")); Serial.print(FreeRam::current());
+    Serial.print(F(" bytes, minima: ")); Serial.println(FreeRam::lowest());
+    Serial.print(F("Aguarda "));
+    Serial.print(BASE_TIME_SEND);
+    Serial.print("s:");
+  #endif
 }
 
+// ***************************************************************************************************
+// *  Tarefa de indicação de funcionamento (a cada 1 segundo)                                        *
+// ***************************************************************************************************
+#if (DEBUG == ON)
+void task_alive(void)
+{
+  // Imprime "." para mostrar que esta rodando
+  Serial.print(F("."));
+}
+#endif
+
 // ***************************************************************************************************
 // *  Função de leitura de sensores                                                                  *
 // ***************************************************************************************************
@@ -287,27 +311,33 @@ void send_data(void)
     Serial.println();
     Serial.print(var[0].Alias);
     Serial.print('\t');
-    Serial.print(var[0].valor);
+    print_value(var[0].valor);
     Serial.print('\t');
     Serial.println(var[0].sensor);
   }
   if (var[1].sensor != OFF){
     Serial.print(var[1].Alias);
     Serial.print('\t');
-    Serial.print(var[1].valor);
+    print_value(var[1].valor);
     Serial.print('\t');
     Serial.println(var[1].sensor);
   }
   if (var[2].sensor != OFF){
     Serial.print(var[2].Alias);
     Serial.print('\t');
-    Serial.print(var[2].valor);
+    print_value(var[2].valor);
     Serial.print('\t');
     Serial.println(var[2].sensor);
   }
     Serial.println();
   #endif
     
+  #if (BATCH == ON)
+    // Envio de todas as leituras acumuladas em uma única requisição
+    send_batch();
+    return;
+  #endif
+
   // Envio da temperatura
   if (TEMP != OFF)
     //send_TCP(var[0].valor, var[0].Alias);
@@ -322,10 +352,59 @@ void send_data(void)
     send_TCP(temperature2, TEMP2_ALIAS);
 }
 
+// ***************************************************************************************************
+// *  Função de envio das leituras acumuladas em lote                                                *
+// ***************************************************************************************************
+#if (BATCH == ON)
+void send_batch(void)
+{
+  byte frame[BATCH_MAX];
+  SampleRing* rings[3] = { &temp_ring, &humi_ring, &temp2_ring };
+  byte counts[3];
+
+  // Leituras que não couberem no pacote ficam para o próximo envio
+  uint8_t len = SampleBatch::encode(rings, 3, t2_millis() / 1000, frame, sizeof(frame), counts);
+  if (len == 0) return;
+
+  // Pacote enviado como texto hexadecimal (decodificadores em SampleBatch-Arduino-SM/extras)
+  String hex = "";
+  char buffer[3];
+  for (uint8_t i = 0; i < len; i++) {
+    sprintf(buffer, "%02X", frame[i]);
+    hex += buffer;
+  }
+  // Leituras só saem dos buffers com a resposta 2xx da plataforma; em erro vão no próximo envio
+  if (send_TCP_value(hex.c_str(), BATCH_ALIAS))
+    SampleBatch::commit(rings, 3, counts);
+}
+#endif
+
+// ***************************************************************************************************
+// *  Impressão de um valor em centésimos                                                            *
+// ***************************************************************************************************
+void print_value(int value)
+{
+  char txt[FP_TEXT];
+  FixedPoint::format(txt, sizeof(txt), value, 2);
+  Serial.print(txt);
+}
+
 // ***************************************************************************************************
 // *  Função de envio de dados TCP                                                                   *
 // ***************************************************************************************************
-void send_TCP(float value, String ALIAS)
+void send_TCP(int value, String ALIAS)
+{
+  // Texto com 2 casas decimais, como o String(float) usado antes
+  char txt[FP_TEXT];
+  FixedPoint::format(txt, sizeof(txt), value, 2);
+  send_TCP_value(txt, ALIAS);
+}
+
+// ***************************************************************************************************
+// *  Função de envio de um valor (texto) via TCP                                                    *
+// *  Retorno: true se a plataforma respondeu com sucesso (HTTP 2xx)                                 *
+// ***************************************************************************************************
+bool send_TCP_value(const char* value, String ALIAS)
 {
   //Variável para buffer de dados de recepção/trasmissão
   uint8_t buffer[300] = {0};
@@ -383,6 +462,7 @@ void send_TCP(float value, String ALIAS)
   
   //Recepção da resposta de retorno
   uint32_t len = wifi.recv(buffer, sizeof(buffer), 10000);
+  bool ok = resp && len > 9 && strncmp((const char*)buffer, "HTTP/1.", 7) == 0 && buffer[9] == '2';
   if (len > 0) {
     #if (DEBUG == ON)
       Serial.println(F("Recebido retorno:"));
@@ -417,6 +497,8 @@ void send_TCP(float value, String ALIAS)
       reset_esp();                  //Reseta o módulo ESP
     #endif
   }
+
+  return ok;
 }
 
 // ***************************************************************************************************
@@ -22,6 +22,13 @@
   #include <SimpleDHT.h>
 #endif
 
+#if (USE_LM35 == ON && (TEMP == LM35 || TEMP2 == LM35))
+  #define USE_ADC     ON        // LM35 lido em segundo plano pela varredura do ADC (AdcScan)
+  #include <AdcScan.h>
+#else
+  #define USE_ADC     OFF
+#endif
+
 // ***************************************************************************************************
 // *  Definição da pinos utilizados nos sensores                                                     *
 // ***************************************************************************************************
@@ -29,6 +36,9 @@
 #if (USE_LM35 == ON)
   const int PIN_LM35 = A2;    //PINO ANALÓGICO UTILIZADO PELO SENSOR LM35
 #endif
+#if (USE_ADC == ON)
+  byte adc_lm35;              // Índice do LM35 na varredura do ADC
+#endif
 
 #if (USE_DHT11 == ON || USE_DHT22 == ON)
   #define PIN_DHT     6         // Pino de comunicação com o DHT
@@ -39,6 +49,61 @@
   SimpleDHT22 dht22(PIN_DHT); 
 #endif
 
+// ***************************************************************************************************
+// *  Função de inicialização dos sensores (chamada no setup)                                        *
+// ***************************************************************************************************
+void setup_sensors(void)
+{
+  #if (USE_LM35 == ON)
+    // Acerta pinagem para sensor LM35
+    pinMode(PIN_LM35, INPUT);
+  #endif
+
+  #if (USE_DHT11 == ON || USE_DHT22 == ON)
+    // Acerta pinagem para sensor DHT
+    pinMode(PIN_DHT, INPUT_PULLUP);
+  #endif
+
+  #if (USE_ADC == ON)
+    // O ADC converte o LM35 a cada estouro do Timer0 (16 leituras por resultado de 12 bits)
+    // e guarda os últimos resultados, que são filtrados por média na leitura
+    adc_lm35 = AdcScan::add(PIN_LM35, AS_AVERAGE);
+    AdcScan::begin(AS_TIMER0);
+  #endif
+}
+
+// ***************************************************************************************************
+// *  Leitura do DHT em ponto fixo: bits decodificados sem float, resultados em centésimos           *
+// *  (temperatura e umidade mantidas em caso de erro)                                               *
+// ***************************************************************************************************
+#if (USE_DHT11 == ON || USE_DHT22 == ON)
+void read_dht(int* temp, int* humi)
+{
+  byte bits[40];
+  int t, h;
+
+  #if (USE_DHT11 == ON)
+    if (dht11.read(NULL, NULL, bits) != SimpleDHTErrSuccess) return;
+    if (!FixedPoint::dht11(bits, &t, &h)) return;
+  #else
+    if (dht22.read(NULL, NULL, bits) != SimpleDHTErrSuccess) return;
+    if (!FixedPoint::dht22(bits, &t, &h)) return;
+  #endif
+
+  // Décimos para centésimos
+  *temp = t * 10;
+  *humi = h * 10;
+}
+#endif
+
+// ***************************************************************************************************
+// *  Valor aleatório x VAL_FAC em centésimos, arredondado (metade para longe do zero)               *
+// ***************************************************************************************************
+int rand_value(void)
+{
+  return FixedPoint::rescale(random(VAL_MIN, VAL_MAX) * VAL_FAC_10K, 4, 2);
+}
+
 // ***************************************************************************************************
 // *  Função de leitura de sensores                                                                  *
 // ***************************************************************************************************
@@ -46,37 +111,37 @@ void read_sensors(void)
 {
     // Definição da Umidade
     #if (HUMI == RAND)
-      humidity = random(VAL_MIN, VAL_MAX) * VAL_FAC;
+      humidity = rand_value();
     #elif (HUMI == DHT11 && USE_DHT11 == ON)
-      dht11.read(&temperature, &humidity, NULL);
+      read_dht(&temperature, &humidity);
     #elif (HUMI == DHT22 && USE_DHT22 == ON)
-      dht22.read2(&temperature, &humidity, NULL);
+      read_dht(&temperature, &humidity);
     #else
       humidity = 0;
     #endif
 
     // Definição da Temperatura
     #if (TEMP == RAND)
-      temperature = random(VAL_MIN, VAL_MAX) * VAL_FAC;
+      temperature = rand_value();
     #elif (TEMP == DHT11 && USE_DHT11 == ON)
-      dht11.read(&temperature, &humidity, NULL);
+      read_dht(&temperature, &humidity);
     #elif (TEMP == DHT22 && USE_DHT22 == ON)
-      dht22.read2(&temperature, &humidity, NULL);
+      read_dht(&temperature, &humidity);
     #elif (TEMP == LM35 && USE_LM35 == ON)
-      temperature = (float(analogRead(PIN_LM35)) * 5 / (1023)) / 0.01;
+      temperature = FixedPoint::lm35(AdcScan::read(adc_lm35), AS_FULL);   // 10mV/°C, fundo de escala 5V
     #else
       temperature = 0;
     #endif
 
         // Definição da Temperatura 2
     #if (TEMP2 == RAND)
-      temperature2 = random(VAL_MIN, VAL_MAX) * VAL_FAC;
+      temperature2 = rand_value();
     #elif (TEMP2 == DHT11 && USE_DHT11 == ON)
-      dht11.read(&temperature2, &humidity, NULL);
+      read_dht(&temperature2, &humidity);
     #elif (TEMP2 == DHT22 && USE_DHT22 == ON)
-      dht22.read2(&temperature2, &humidity, NULL);
+      read_dht(&temperature2, &humidity);
     #elif (TEMP2 == LM35 && USE_LM35 == ON)
-      temperature2 = (float(analogRead(PIN_LM35)) * 5 / (1023)) / 0.01;
+      temperature2 = FixedPoint::lm35(AdcScan::read(adc_lm35), AS_FULL);   // 10mV/°C, fundo de escala 5V
     #else
       temperature2 = 0;
     #endif
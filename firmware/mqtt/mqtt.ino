@@ -1,6 +1,7 @@
 #include <SPI.h>
 #include <Ethernet.h>
 #include <PubSubClient.h>
+#include <FreeRam.h>
 
 /**************************** Variaveis globais *******************************/
 
@@ -66,5 +67,10 @@ void loop() {
   client.publish("device/5ef20c1f47f0e40019a54876", "ok");
   digitalWrite(LED_BUILTIN, 0);
 
+  Serial.print("Free RAM: ");
+  Serial.print(FreeRam::current());
+  Serial.print(", lowest: ");
+  Serial.println(FreeRam::lowest());
+
   delay(2000);
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+//==========================================================================
+// A library to sample the analog inputs in the background.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+//==========================================================================
+
+#include "Arduino.h"
+#include "AdcScan.h"
+
+byte AdcScan::_mux[AS_CHANNELS];
+byte AdcScan::_filter[AS_CHANNELS];
+byte AdcScan::_n = 0;
+byte AdcScan::_ref = 0;
+byte AdcScan::_trigger = AS_TIMER0;
+bool AdcScan::_running = false;
+
+volatile uint16_t AdcScan::_ring[AS_CHANNELS][AS_DEPTH];
+volatile byte AdcScan::_head[AS_CHANNELS];
+volatile byte AdcScan::_count[AS_CHANNELS];
+
+byte AdcScan::_cur = 0;
+byte AdcScan::_samples = 0;
+bool AdcScan::_skip = true;
+uint16_t AdcScan::_sum = 0;
+
+//==========================================================================
+ISR(ADC_vect)
+{
+  AdcScan::handleInterrupt();
+}
+
+//==========================================================================
+byte AdcScan::add(byte pin, byte filter)
+{
+  if (_running || _n >= AS_CHANNELS) return AS_NONE;
+
+  // Accept pin numbers (A0, A1...) or channel numbers, as analogRead()
+  if (pin >= A0) pin -= A0;
+#if defined(analogPinToChannel)
+  pin = analogPinToChannel(pin);
+#endif
+
+  _mux[_n] = pin;
+  _filter[_n] = filter;
+  _count[_n] = 0;
+  _head[_n] = 0;
+  return _n++;
+}
+
+//==========================================================================
+void AdcScan::begin(byte trigger, byte reference)
+{
+  if (_n == 0) return;
+  end();
+
+  _ref = reference << 6;
+  _trigger = trigger;
+  _cur = 0;
+  _sum = 0;
+  _samples = 0;
+  _skip = true;
+  select(0);
+
+  // Keep the prescaler set by the core, clear a pending interrupt
+  ADCSRA = (ADCSRA & 0x07) | (1 << ADEN) | (1 << ADIE) | (1 << ADIF);
+  _running = true;
+
+  if (_trigger == AS_TIMER0)
+  {
+    // Auto trigger source = Timer0 overflow (ADTS = 100)
+    ADCSRB = (ADCSRB & ~0x07) | (1 << ADTS2);
+    ADCSRA |= (1 << ADATE);
+  }
+  else
+  {
+    // The interrupt starts the next conversion
+    ADCSRA |= (1 << ADSC);
+  }
+}
+
+//==========================================================================
+void AdcScan::end(void)
+{
+  if (!_running) return;
+
+  ADCSRA &= ~((1 << ADIE) | (1 << ADATE));
+  while (ADCSRA & (1 << ADSC));
+  ADCSRB &= ~0x07;
+  ADCSRA |= (1 << ADIF);
+  _running = false;
+}
+
+//==========================================================================
+byte AdcScan::available(byte index)
+{
+  if (index >= _n) return 0;
+  return _count[index];
+}
+
+//==========================================================================
+uint16_t AdcScan::read(byte index)
+{
+  uint16_t v[AS_DEPTH];
+  byte n;
+
+  if (index >= _n) return 0;
+
+  // Copy the ring without the interrupt changing it
+  uint8_t sreg = SREG;
+  cli();
+  n = _count[index];
+  for (byte i=0; i<n; i++)
+    v[i] = _ring[index][i];
+  SREG = sreg;
+
+  if (n == 0) return 0;
+
+  if (_filter[index] == AS_MEDIAN)
+  {
+    // Insertion sort (at most AS_DEPTH values)
+    for (byte i=1; i<n; i++)
+    {
+      uint16_t x = v[i];
+      byte j = i;
+      while (j > 0 && v[j-1] > x)
+      {
+        v[j] = v[j-1];
+        j--;
+      }
+      v[j] = x;
+    }
+    return v[n / 2];
+  }
+
+  unsigned long sum = 0;
+  for (byte i=0; i<n; i++)
+    sum += v[i];
+  return (sum + n / 2) / n;
+}
+
+//==========================================================================
+uint16_t AdcScan::millivolts(byte index, uint16_t vref)
+{
+  return ((unsigned long)read(index) * vref + AS_FULL / 2) / AS_FULL;
+}
+
+//==========================================================================
+void AdcScan::select(byte index)
+{
+  ADMUX = _ref | (_mux[index] & 0x07);
+#if defined(MUX5)
+  // Channels 8 - 15 of the Mega
+  if (_mux[index] & 0x08)
+    ADCSRB |= (1 << MUX5);
+  else
+    ADCSRB &= ~(1 << MUX5);
+#endif
+}
+
+//==========================================================================
+void AdcScan::handleInterrupt(void)
+{
+  uint16_t v = ADC;
+
+  if (_skip)
+  {
+    // The conversion may have started before the channel change
+    _skip = false;
+  }
+  else
+  {
+    _sum += v;
+    if (++_samples == AS_OVERSAMPLE)
+    {
+      // Decimate: AS_OVERSAMPLE conversions give AS_BITS extra bits
+      byte c = _cur;
+      byte h = _head[c];
+      _ring[c][h] = _sum >> AS_BITS;
+      _head[c] = (h + 1 == AS_DEPTH) ? 0 : h + 1;
+      if (_count[c] < AS_DEPTH) _count[c]++;
+      _sum = 0;
+      _samples = 0;
+
+      // Next input
+      if (_n > 1)
+      {
+        _cur = (c + 1 == _n) ? 0 : c + 1;
+        select(_cur);
+        _skip = true;
+      }
+    }
+  }
+
+  if (_trigger == AS_FREE)
+    ADCSRA |= (1 << ADSC);
+}
@@ -0,0 +1,117 @@
+//==========================================================================
+// A library to sample the analog inputs in the background.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// The ADC is driven by its conversion complete interrupt and scans the
+// added inputs in turn. Each input is oversampled AS_OVERSAMPLE times and
+// decimated to 12 bits (0 - 4092); the last AS_DEPTH results are kept in a
+// ring and filtered (average or median) when read(), which never waits
+// for a conversion.
+//
+// Notes:
+//   - analogRead() must not be used while the scan is running (it shares
+//     the ADC). end() stops the scan and gives the ADC back.
+//   - Oversampling only adds resolution with some noise on the input
+//     (the 1 - 2 LSB usually present on the ADC is enough).
+//   - AS_TIMER0 starts one conversion per Timer0 overflow (~976/s with the
+//     Arduino core), AS_FREE runs the conversions back to back (~9600/s
+//     with the default ADC clock).
+//
+//==========================================================================
+
+#ifndef AdcScan_h
+#define	AdcScan_h
+
+#include "Arduino.h"
+
+// Maximum number of scanned inputs
+#define AS_CHANNELS     4
+// Results kept per input (filter window)
+#define AS_DEPTH        5
+// Extra bits obtained by oversampling and conversions per result (4^bits)
+#define AS_BITS         2
+#define AS_OVERSAMPLE   (1 << (2 * AS_BITS))
+// Full scale of the results (12 bits)
+#define AS_FULL         4096
+
+// Filters
+#define AS_AVERAGE      0
+#define AS_MEDIAN       1
+
+// Conversion triggers
+#define AS_TIMER0       0
+#define AS_FREE         1
+
+// Returned by add() when no input is available
+#define AS_NONE         255
+
+class AdcScan
+{
+  public:
+
+    // =================================================================================================
+    // Add an analog input to the scan (before begin()). Returns the index used by read(),
+    // or AS_NONE if AS_CHANNELS inputs were already added or the scan is running.
+	// pin = analog pin (A0, A1, ...) or channel number
+	// filter = AS_AVERAGE (noise) or AS_MEDIAN (spikes and level changes, e.g. buttons)
+    // =================================================================================================
+    static byte add(byte pin, byte filter = AS_AVERAGE);
+
+    // =================================================================================================
+    // Start the scan.
+	// trigger = AS_TIMER0 or AS_FREE
+	// reference = analog reference (DEFAULT, INTERNAL, EXTERNAL...), as analogReference()
+    // =================================================================================================
+    static void begin(byte trigger = AS_TIMER0, byte reference = DEFAULT);
+
+    // =================================================================================================
+    // Stop the scan (analogRead() can be used again). The results already stored are kept.
+    // =================================================================================================
+    static void end(void);
+
+    // =================================================================================================
+    // Number of results stored for the input (0 = no result yet, read() returns 0).
+    // =================================================================================================
+    static byte available(byte index);
+
+    // =================================================================================================
+    // Filtered value of the input (0 - 4092, 12 bits). Does not wait for the ADC.
+    // =================================================================================================
+    static uint16_t read(byte index);
+
+    // =================================================================================================
+    // Filtered value of the input in millivolts.
+	// vref = reference voltage in millivolts
+    // =================================================================================================
+    static uint16_t millivolts(byte index, uint16_t vref = 5000);
+
+    // =================================================================================================
+    // Called by the ADC interrupt.
+    // =================================================================================================
+    static void handleInterrupt(void);
+
+  private:
+
+    static byte _mux[AS_CHANNELS];					// ADC channel of each input
+    static byte _filter[AS_CHANNELS];				// Filter of each input
+    static byte _n;									// Number of inputs
+    static byte _ref;								// REFS bits of ADMUX
+    static byte _trigger;							// AS_TIMER0 / AS_FREE
+    static bool _running;
+
+    static volatile uint16_t _ring[AS_CHANNELS][AS_DEPTH];	// Decimated results
+    static volatile byte _head[AS_CHANNELS];		// Next position written in the ring
+    static volatile byte _count[AS_CHANNELS];		// Results stored in the ring
+
+    // Used only by the interrupt
+    static byte _cur;								// Input being converted
+    static byte _samples;							// Conversions added to _sum
+    static bool _skip;								// Discard the first conversion after a channel change
+    static uint16_t _sum;
+
+    static void select(byte index);
+};
+
+#endif
@@ -0,0 +1,110 @@
+//==========================================================================
+// A library to convert and format sensor readings with integer
+// fixed-point math (no float).
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+//==========================================================================
+
+#include "Arduino.h"
+#include "FixedPoint.h"
+
+//==========================================================================
+bool FixedPoint::pack(const byte* bits, byte* data)
+{
+  for (byte i=0; i<5; i++)
+    data[i] = 0;
+  for (byte i=0; i<40; i++)
+    data[i >> 3] = (data[i >> 3] << 1) | (bits[i] & 1);
+
+  return (byte)(data[0] + data[1] + data[2] + data[3]) == data[4];
+}
+
+//==========================================================================
+bool FixedPoint::dht22(const byte* bits, int* temperature, int* humidity)
+{
+  byte data[5];
+
+  if (!pack(bits, data)) return false;
+
+  // 16 bits x 10; bit 15 of the temperature is the sign
+  int t = ((data[2] & 0x7F) << 8) | data[3];
+  if (temperature) *temperature = (data[2] & 0x80) ? -t : t;
+  if (humidity) *humidity = (data[0] << 8) | data[1];
+  return true;
+}
+
+//==========================================================================
+bool FixedPoint::dht11(const byte* bits, int* temperature, int* humidity)
+{
+  byte data[5];
+
+  if (!pack(bits, data)) return false;
+
+  // Integer and decimal bytes; bit 7 of the temperature decimal is the sign
+  int t = data[2] * 10 + (data[3] & 0x7F);
+  if (temperature) *temperature = (data[3] & 0x80) ? -t : t;
+  if (humidity) *humidity = data[0] * 10 + data[1];
+  return true;
+}
+
+//==========================================================================
+long FixedPoint::rescale(long value, byte from, byte to)
+{
+  while (to > from)
+  {
+    value *= 10;
+    to--;
+  }
+  if (from > to)
+  {
+    long div = 1;
+    while (from > to)
+    {
+      div *= 10;
+      from--;
+    }
+    value = (value < 0) ? (value - div / 2) / div : (value + div / 2) / div;
+  }
+  return value;
+}
+
+//==========================================================================
+uint8_t FixedPoint::format(char* out, uint8_t size, long value, byte decimals)
+{
+  char digits[10];
+  uint8_t n = 0;
+  bool neg = value < 0;
+  unsigned long v = neg ? 0UL - (unsigned long)value : (unsigned long)value;
+
+  // Digits in reverse order: 32 bit divisions only while the value needs them
+  while (v > 0xFFFF)
+  {
+    digits[n++] = '0' + (v % 10);
+    v /= 10;
+  }
+  uint16_t w = v;
+  do
+  {
+    digits[n++] = '0' + (w % 10);
+    w /= 10;
+  } while ((w || n <= decimals) && n < sizeof(digits));
+
+  uint8_t len = n + neg + (decimals ? 1 : 0);
+  if (len >= size)
+  {
+    if (size) out[0] = '\0';
+    return 0;
+  }
+
+  char* p = out;
+  if (neg) *p++ = '-';
+  while (n)
+  {
+    if (n == decimals) *p++ = '.';
+    *p++ = digits[--n];
+  }
+  *p = '\0';
+  return len;
+}
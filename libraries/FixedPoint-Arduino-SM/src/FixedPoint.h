@@ -0,0 +1,70 @@
+//==========================================================================
+// A library to convert and format sensor readings with integer
+// fixed-point math (no float).
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// Values are integers scaled by 10^decimals: 2534 with 2 decimals is
+// 25.34. The AVR has no FPU, so the float conversions and String(float)
+// formatting are emulated in software; these routines use only integer
+// math and write the text into a buffer given by the caller.
+//
+// Benchmarks: tools/fixbench (host equivalence and timing, on-target
+// sketches for cycles and flash).
+//
+//==========================================================================
+
+#ifndef FixedPoint_h
+#define	FixedPoint_h
+
+#include "Arduino.h"
+
+// Buffer size that holds any formatted long (sign, 10 digits, point and '\0')
+#define FP_TEXT         13
+
+class FixedPoint
+{
+  public:
+
+    // =================================================================================================
+    // LM35 temperature (10 mV/°C) in hundredths of °C.
+	// raw = ADC reading, full = ADC full scale (1024 for analogRead(), 4096 for 12 bits)
+	// vref = reference voltage in millivolts
+	// Inline so a constant full scale (power of 2) becomes a shift.
+    // =================================================================================================
+    static long lm35(uint16_t raw, uint16_t full, uint16_t vref = 5000)
+    {
+      return ((unsigned long)raw * vref * 10 + full / 2) / full;
+    }
+
+    // =================================================================================================
+    // Decode the 40 bits read from a DHT22 (pdata of SimpleDHT, one bit per byte, MSB first).
+	// temperature / humidity = results in tenths (°C / %RH), NULL if not needed
+	// Returns false if the checksum does not match (results not changed).
+    // =================================================================================================
+    static bool dht22(const byte* bits, int* temperature, int* humidity);
+
+    // =================================================================================================
+    // Same as dht22() for the DHT11 (integer and decimal bytes), results in tenths.
+    // =================================================================================================
+    static bool dht11(const byte* bits, int* temperature, int* humidity);
+
+    // =================================================================================================
+    // Change the number of decimals of a value (rounding half away from zero).
+    // =================================================================================================
+    static long rescale(long value, byte from, byte to);
+
+    // =================================================================================================
+    // Write the value as decimal text ("-12.34") in out, terminated by '\0'.
+	// decimals = decimal places of the value (digits after the point)
+	// Returns the text length, or 0 if it does not fit in size bytes (out = "").
+    // =================================================================================================
+    static uint8_t format(char* out, uint8_t size, long value, byte decimals);
+
+  private:
+
+    static bool pack(const byte* bits, byte* data);
+};
+
+#endif
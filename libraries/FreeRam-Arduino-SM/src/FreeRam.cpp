@@ -0,0 +1,72 @@
+//==========================================================================
+// A library to measure the free RAM between the heap and the stack,
+// including the lowest value reached since the reset (high-water mark).
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+//==========================================================================
+
+#include "Arduino.h"
+#include "FreeRam.h"
+
+#ifdef __AVR__
+
+// Symbols of the linker script: start of the heap, top of the heap (0 before
+// the first malloc()) and top of the RAM
+extern char __heap_start;
+extern char* __brkval;
+extern char __stack;
+
+// Runs from .init3 (stack pointer set, r1 cleared, before the constructors):
+// nothing is on the stack yet, so all the RAM above the heap start is painted
+void fr_paint(void) __attribute__((naked, used, section(".init3")));
+void fr_paint(void)
+{
+  for (byte* p = (byte*)&__heap_start; p <= (byte*)&__stack; p++)
+    *p = FR_PAINT;
+}
+
+//==========================================================================
+unsigned int FreeRam::current(void)
+{
+  char top;
+  char* heap = __brkval ? __brkval : &__heap_start;
+  return (unsigned int)(&top - heap);
+}
+
+//==========================================================================
+unsigned int FreeRam::lowest(void)
+{
+  byte* p = (byte*)(__brkval ? __brkval : &__heap_start);
+  byte* sp = (byte*)SP;
+  unsigned int n = 0;
+
+  // Skip the blocks freed at the top of the heap (already written)
+  while (p < sp && *p != FR_PAINT)
+    p++;
+
+  // Paint left between the heap and the deepest stack
+  while (p < sp && *p == FR_PAINT)
+  {
+    p++;
+    n++;
+  }
+  return n;
+}
+
+#else
+
+//==========================================================================
+unsigned int FreeRam::current(void)
+{
+  return 0;
+}
+
+//==========================================================================
+unsigned int FreeRam::lowest(void)
+{
+  return 0;
+}
+
+#endif
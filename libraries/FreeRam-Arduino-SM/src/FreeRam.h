@@ -0,0 +1,44 @@
+//==========================================================================
+// A library to measure the free RAM between the heap and the stack,
+// including the lowest value reached since the reset (high-water mark).
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// At reset (before the constructors and setup()) the RAM above the static
+// variables is painted with FR_PAINT. The stack and the heap (String)
+// overwrite the paint as they grow, so the paint left between them is the
+// smallest free RAM seen so far, including interrupts and deep call chains
+// that a single reading in loop() would miss.
+//
+// Notes:
+//   - Only the AVR is supported; the other cores return 0.
+//   - A stored byte equal to FR_PAINT ends the dirty area early, so the
+//     result may be a few bytes larger than the real minimum.
+//
+//==========================================================================
+
+#ifndef FreeRam_h
+#define	FreeRam_h
+
+#include "Arduino.h"
+
+// Value written on the free RAM at reset
+#define FR_PAINT        0xA5
+
+class FreeRam
+{
+  public:
+
+    // =================================================================================================
+    // Free RAM now: bytes between the top of the heap and the stack pointer.
+    // =================================================================================================
+    static unsigned int current(void);
+
+    // =================================================================================================
+    // Smallest free RAM since the reset: paint never touched by the heap or the stack (bytes).
+    // =================================================================================================
+    static unsigned int lowest(void);
+};
+
+#endif
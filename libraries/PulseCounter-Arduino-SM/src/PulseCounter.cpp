@@ -0,0 +1,132 @@
+//==========================================================================
+// A library to count pulses with the external interrupts.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+//==========================================================================
+
+#include "Arduino.h"
+#include "PulseCounter.h"
+
+byte PulseCounter::_pin[PC_INPUTS];
+byte PulseCounter::_n = 0;
+bool PulseCounter::_ended = false;
+unsigned long PulseCounter::_debounce[PC_INPUTS];
+
+volatile unsigned long PulseCounter::_count[PC_INPUTS];
+volatile unsigned long PulseCounter::_rejected[PC_INPUTS];
+volatile unsigned long PulseCounter::_last[PC_INPUTS];
+
+// attachInterrupt() takes a function without arguments: one trampoline per input
+static void pc_isr0(void) { PulseCounter::handleInterrupt(0); }
+static void pc_isr1(void) { PulseCounter::handleInterrupt(1); }
+static void pc_isr2(void) { PulseCounter::handleInterrupt(2); }
+static void pc_isr3(void) { PulseCounter::handleInterrupt(3); }
+
+static void (* const pc_isr[PC_INPUTS])(void) = { pc_isr0, pc_isr1, pc_isr2, pc_isr3 };
+
+//==========================================================================
+byte PulseCounter::add(byte pin, unsigned long debounce, byte mode)
+{
+  if (_ended)
+  {
+    _n = 0;
+    _ended = false;
+  }
+  if (_n >= PC_INPUTS) return PC_NONE;
+  if (digitalPinToInterrupt(pin) == NOT_AN_INTERRUPT) return PC_NONE;
+  for (byte i=0; i<_n; i++)
+    if (_pin[i] == pin) return PC_NONE;
+
+  byte i = _n;
+  _pin[i] = pin;
+  _debounce[i] = debounce;
+  _count[i] = 0;
+  _rejected[i] = 0;
+  _last[i] = micros() - debounce;   // The first edge is always counted
+  _n++;
+
+  attachInterrupt(digitalPinToInterrupt(pin), pc_isr[i], mode);
+  return i;
+}
+
+//==========================================================================
+void PulseCounter::end(void)
+{
+  // Only the interrupts are released: the counts not taken yet stay readable
+  for (byte i=0; i<_n; i++)
+    detachInterrupt(digitalPinToInterrupt(_pin[i]));
+  _ended = true;
+}
+
+//==========================================================================
+unsigned long PulseCounter::read(byte index)
+{
+  unsigned long n;
+
+  if (index >= _n) return 0;
+
+  uint8_t sreg = SREG;
+  cli();
+  n = _count[index];
+  SREG = sreg;
+  return n;
+}
+
+//==========================================================================
+unsigned long PulseCounter::take(byte index)
+{
+  unsigned long n;
+
+  if (index >= _n) return 0;
+
+  uint8_t sreg = SREG;
+  cli();
+  n = _count[index];
+  _count[index] = 0;
+  SREG = sreg;
+  return n;
+}
+
+//==========================================================================
+void PulseCounter::takeAll(unsigned long* counts)
+{
+  uint8_t sreg = SREG;
+  cli();
+  for (byte i=0; i<_n; i++)
+  {
+    counts[i] = _count[i];
+    _count[i] = 0;
+  }
+  SREG = sreg;
+}
+
+//==========================================================================
+unsigned long PulseCounter::rejected(byte index)
+{
+  unsigned long n;
+
+  if (index >= _n) return 0;
+
+  uint8_t sreg = SREG;
+  cli();
+  n = _rejected[index];
+  _rejected[index] = 0;
+  SREG = sreg;
+  return n;
+}
+
+//==========================================================================
+void PulseCounter::handleInterrupt(byte index)
+{
+  unsigned long t = micros();
+
+  if (t - _last[index] < _debounce[index])
+  {
+    _rejected[index]++;
+    return;
+  }
+  _last[index] = t;
+  _count[index]++;
+}
@@ -0,0 +1,92 @@
+//==========================================================================
+// A library to count pulses with the external interrupts.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// Each input is counted by its own interrupt (attachInterrupt), so no
+// pulse is missed while the main loop is blocked (e.g. waiting for the
+// RN2903). Debounce is done by timestamp: after a counted edge, edges
+// closer than the debounce time are rejected.
+//
+// Notes:
+//   - Only pins with an external interrupt can be used
+//     (UNO: 2, 3 / Mega: 2, 3, 18, 19, 20, 21).
+//   - Pin change interrupts are not used: SoftwareSerial takes all their
+//     vectors.
+//   - The AVR keeps one pending edge per input: while interrupts are off
+//     (e.g. SoftwareSerial sending or receiving a byte) a second edge is
+//     lost. tools/pulsesim estimates the maximum rate counted exactly.
+//
+//==========================================================================
+
+#ifndef PulseCounter_h
+#define	PulseCounter_h
+
+#include "Arduino.h"
+
+// Maximum number of inputs
+#define PC_INPUTS       4
+
+// Returned by add() when the pin can not be used
+#define PC_NONE         255
+
+class PulseCounter
+{
+  public:
+
+    // =================================================================================================
+    // Start counting an input. Returns the index used by the other methods, or PC_NONE if
+    // the pin has no external interrupt, is already used or PC_INPUTS inputs were added.
+	// pin = digital pin (configure it with pinMode() first)
+	// debounce = minimum time between counted edges in microseconds (0 = no debounce)
+	// mode = edge counted (FALLING, RISING or CHANGE)
+    // =================================================================================================
+    static byte add(byte pin, unsigned long debounce, byte mode = FALLING);
+
+    // =================================================================================================
+    // Stop counting all inputs. The inputs and their counters are kept: read(), take(),
+	// takeAll() and rejected() still return what was counted. The next add() starts over
+	// with no inputs.
+    // =================================================================================================
+    static void end(void);
+
+    // =================================================================================================
+    // Pulses counted by the input since the last take().
+    // =================================================================================================
+    static unsigned long read(byte index);
+
+    // =================================================================================================
+    // Pulses counted by the input since the last take(), clearing the counter in the same
+    // atomic operation (no pulse is lost between the read and the clear).
+    // =================================================================================================
+    static unsigned long take(byte index);
+
+    // =================================================================================================
+    // take() of all inputs at the same instant. counts = array with one position per input.
+    // =================================================================================================
+    static void takeAll(unsigned long* counts);
+
+    // =================================================================================================
+    // Edges rejected by the debounce since the last call.
+    // =================================================================================================
+    static unsigned long rejected(byte index);
+
+    // =================================================================================================
+    // Called by the interrupt of the input.
+    // =================================================================================================
+    static void handleInterrupt(byte index);
+
+  private:
+
+    static byte _pin[PC_INPUTS];						// Pin of each input
+    static byte _n;										// Number of inputs
+    static bool _ended;									// end() was called: next add() starts over
+    static unsigned long _debounce[PC_INPUTS];			// Debounce (us)
+
+    static volatile unsigned long _count[PC_INPUTS];	// Pulses since the last take()
+    static volatile unsigned long _rejected[PC_INPUTS];	// Edges rejected by the debounce
+    static volatile unsigned long _last[PC_INPUTS];		// Time (us) of the last counted edge
+};
+
+#endif
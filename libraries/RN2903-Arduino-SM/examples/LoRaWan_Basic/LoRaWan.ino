@@ -13,19 +13,52 @@
 // ***************************************************************************************************
 #define ABP             1
 #define OTAA            2
+#define AUTO            3
 #define PRINT_PARAMS    ON        // Imprime parametros salvos no RN2903
 #define DEBUG_RN2903    ON        // Imprime mensagens de Debug do RN2903
 
+#define LORA_PROFILE    ON        // Configuração fixa do RN2903 gerada em tempo de compilação
+#define LORA_SB         0         // Índice da sub-banda
+#define LORA_CH         255       // 0 a 63 = Canal único (0 = 902.3MHz) / 255 = Sub-banda
+#define LORA_HOP        ON        // Seleção de canais pelo driver com estatística por canal
+                                  // Exige LORA_ADR OFF: com ADR ON a seleção é desligada
+#define HOP_MIN         3         // Número mínimo de canais mantidos ativos
+#define HOP_EPOCH       32        // Transmissões entre atualizações dos canais ativos
 #define LORA_PW         5         // Potência inicial do rádio
+#define LORA_WINDOW     1         // Comandos enviados em sequência antes de ler as respostas
+                                  // Só o MEGA (Serial1) admite mais de 1, ainda não verificado no
+                                  // RN2903 real (ver README). No UNO a SoftwareSerial perde o que
+                                  // recebe enquanto transmite: manter 1
 #define LORA_DR         2         // Data Rate
-#define LORA_ADR        ON        // Adaptative Data Rate
+#define LORA_ADR        OFF       // Adaptative Data Rate (ON desliga LORA_HOP; o Data Rate fica
+                                  // fixo em LORA_DR com OFF)
 #define LORA_AR         OFF       // Repetição automática de TX
 #define LORA_REP        2         // Número de repetições de TX
 
-#define TX_CNF          ON        // Confirmação de TX
+#define TX_CNF          AUTO      // Confirmação de TX (ON, OFF ou AUTO = adaptativa conforme perdas)
+#define CNF_EVERY       8         // AUTO: confirma pelo menos 1 a cada N transmissões
+#define CNF_LOSS        20        // AUTO: perda estimada (%) acima da qual todas são confirmadas
+#define CNF_MARGIN      5         // AUTO: margem do enlace (dB) abaixo da qual todas são confirmadas
+#define LINK_CHECK      600       // Intervalo do Link Check para leitura da margem (s), 0 = desliga
 #define TX_ERRORS       3         // Número máximo de erros antes de resetar o RN2903
 #define MAX_JOIN        3         // Número máximo de tentativa de JOIN sem sucesso
 #define TX_LORA         ON        // Desativa o uso do rádio para facilitar o debug da lógica principal
+#define KEYS_EEPROM     OFF       // Chaves lidas da EEPROM (gravadas na primeira inicialização)
+#define KEYS_ADDR       0         // Endereço das chaves na EEPROM (ocupa RN2903_EE_SIZE bytes)
+
+// ***************************************************************************************************
+// *  Perfil de configuração do RN2903 (comandos gerados em tempo de compilação e mantidos na flash) *
+// ***************************************************************************************************
+#if (LORA_PROFILE==ON)
+  #define RN2903_SB     LORA_SB
+  #define RN2903_CH     LORA_CH
+  #define RN2903_DR     LORA_DR
+  #define RN2903_ADR    LORA_ADR
+  #define RN2903_AR     LORA_AR
+  #define RN2903_RETX   LORA_REP
+  #define RN2903_PW     LORA_PW
+  #include <rn2903_profile.h>
+#endif
 
 // ***************************************************************************************************
 // *  Definições do Node                                                                             *
@@ -46,6 +79,8 @@
 #define AL_SNR          "B1"      // Alias para variável de SNR
 #define TX_VDD          OFF       // Transmite VDD  no Payload do LoRa
 #define AL_VDD          "B2"      // Alias para variável de VDD
+#define TX_LOSS         OFF       // Transmite perda estimada (%) no Payload do LoRa
+#define AL_LOSS         "B3"      // Alias para variável de perda
 
 // Configuração do Payload manual (botão presionado)
 #define TX_BT           ON        // Transmite Botão no Payload do LoRa
@@ -70,6 +105,15 @@
   #undef  TX_COUNTER
   #define TX_COUNTER    OFF
 #endif
+#if (LORA_CH!=255)
+  #undef  LORA_HOP
+  #define LORA_HOP      OFF
+#endif
+#if (LORA_ADR==ON)
+  // Com ADR a máscara de canais é do servidor de rede (LinkADRReq): o driver não pode alterá-la
+  #undef  LORA_HOP
+  #define LORA_HOP      OFF
+#endif
 
 
 // ***************************************************************************************************
@@ -111,18 +155,36 @@
 // ***************************************************************************************************
 void print_params(void){
 #if (DEBUG==ON && PRINT_PARAMS==ON)
-  String st;
+  byte ticket[RN2903_QUEUE];
   // Imprime quais canais estão ligados e com que frequência
-  for (int i=0; i<64; i++)
+  // As consultas são enviadas em grupos pela fila de comandos do RN2903
+  for (int i=0; i<64; i+=RN2903_QUEUE)
   {
-    st = myLora.sendRawCommand("mac get ch status "+String(i));
-    if(st=="on")
+    for (byte j=0; j<RN2903_QUEUE; j++)
     {
-      Serial.print(F("Canal "));
-      Serial.print(i);
-      Serial.print(F(": ON / "));
-      Serial.print(myLora.sendRawCommand("mac get ch freq "+String(i)));
-      Serial.println(F(" Hz"));
+      ticket[j] = myLora.queue("mac get ch status "+String(i+j), true);
+    }
+    myLora.flushQueue();
+
+    for (byte j=0; j<RN2903_QUEUE; j++)
+    {
+      // Sem ticket livre o comando com resultado não é enviado
+      if (ticket[j]==RN2903_NO_TICKET)
+      {
+        Serial.print(F("Canal "));
+        Serial.print(i+j);
+        Serial.println(F(": sem ticket"));
+        continue;
+      }
+      if (myLora.cmdStatus(ticket[j])==RN2903_CMD_DONE && strcmp(myLora.cmdReply(ticket[j]),"on")==0)
+      {
+        Serial.print(F("Canal "));
+        Serial.print(i+j);
+        Serial.print(F(": ON / "));
+        Serial.print(myLora.sendRawCommand("mac get ch freq "+String(i+j)));
+        Serial.println(F(" Hz"));
+      }
+      myLora.release(ticket[j]);
     }
   }
 
@@ -176,6 +238,11 @@ void print_params(void){
 // ***************************************************************************************************
 void manual_tx(void)
 {
+    #if (COUNTER==ON)
+      // Pulsos contados desde a última leitura
+      update_counter();
+    #endif
+
     // Imprime DEBUG
     #if (DEBUG==ON)
       Serial.print(F("Botão: "));
@@ -230,12 +297,26 @@ void manual_tx(void)
 // ***************************************************************************************************
 void auto_tx(void)
 {
+    #if (BATCH==ON)
+      // Leituras acumuladas desde a última transmissão
+      tx_batch();
+      return;
+    #endif
+
+    #if (COUNTER==ON)
+      // Pulsos contados desde a última leitura
+      update_counter();
+    #endif
+
     // Imprime DEBUG
     #if (DEBUG==ON)
       #if (DHT22==ON)
           // Sensor de Temperatura e Umidade DHT22
-          Serial.print(F("Temp: ")); Serial.print((float)temperature); Serial.print(F("°C, "));
-          Serial.print(F("Umid: ")); Serial.print((float)humidity); Serial.print(F("%, "));
+          char txt[FP_TEXT];
+          FixedPoint::format(txt, sizeof(txt), temperature, 2);
+          Serial.print(F("Temp: ")); Serial.print(txt); Serial.print(F("°C, "));
+          FixedPoint::format(txt, sizeof(txt), humidity, 2);
+          Serial.print(F("Umid: ")); Serial.print(txt); Serial.print(F("%, "));
       #endif
       #if (COUNTER==ON)
         // Sensor de presença - Contador
@@ -248,14 +329,19 @@ void auto_tx(void)
    
     // Prepara PAYLOAD para transmissão
     String payload = "";
+    #if (TX_TEMP==ON || TX_HUMI==ON)
+      char value[FP_TEXT];      // Texto do valor em ponto fixo (mesmo formato de String(float))
+    #endif
 
     #if (TX_TEMP==ON)
       payload += AL_TEMP;
-      payload += temperature;
+      FixedPoint::format(value, sizeof(value), temperature, 2);
+      payload += value;
     #endif
     #if (TX_HUMI==ON) 
       payload += AL_HUMI;
-      payload += humidity;
+      FixedPoint::format(value, sizeof(value), humidity, 2);
+      payload += value;
     #endif 
     #if (TX_COUNTER==ON)
       payload += AL_COUNTER;
@@ -285,6 +371,10 @@ void auto_tx(void)
       payload += AL_VDD;
       payload += format_zero((String) vdd,4); 
     #endif
+    #if (TX_LOSS==ON)
+      payload += AL_LOSS;
+      payload += format_zero((String) myLora.getLossRate(),3); 
+    #endif
         
     // Transmite PAYLOAD
     tx_payload(payload);
@@ -313,14 +403,98 @@ void tx_payload(String payload)
     
     // Executa transmissão do pacote (payload)
     led_on();
-    //tx_type = myLora.tx(payload, TX_CNF);
+    // Botões 3 e 4 sempre solicitam confirmação
     if (button>=3){
       tx_type = myLora.tx(payload, ON);
     }else{
-      tx_type = myLora.tx(payload, OFF);
+      #if (TX_CNF==AUTO)
+        tx_type = myLora.txAuto(payload);
+      #else
+        tx_type = myLora.tx(payload, TX_CNF);
+      #endif
     }
     led_off();
 
+    // Trata o resultado da transmissão
+    tx_check(tx_type);
+}
+
+// ***************************************************************************************************
+// *  Função: tx_batch                                                                               *
+// *  Descrição: Função para transmissão das leituras acumuladas em um pacote delta-codificado       *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+#if (BATCH==ON)
+void tx_batch(void)
+{
+    byte frame[BATCH_MAX];
+    SampleRing* rings[] = {
+      #if (DHT22==ON)
+        &temp_ring, &humi_ring,
+      #endif
+      #if (COUNTER==ON)
+        &counter_ring,
+      #endif
+    };
+
+    const byte n = sizeof(rings) / sizeof(rings[0]);
+    byte counts[n];
+
+    // Leituras que não couberem no pacote ficam para a próxima transmissão
+    uint8_t len = SampleBatch::encode(rings, n, t2_millis() / 1000, frame, sizeof(frame), counts);
+    if (len == 0) return;
+
+    #if (DEBUG==ON)
+      Serial.print(F("Lote: "));
+      Serial.print(len);
+      Serial.println(F(" bytes"));
+    #endif
+
+    // Sem transmissão as leituras continuam nos buffers
+    #if (TX_LORA==OFF)
+      Serial.println(F("Simulando transmissão..."));
+      return;
+    #endif
+
+    TX_RETURN_TYPE tx_type;
+    led_on();
+    #if (TX_CNF==AUTO)
+      tx_type = myLora.txBytesAuto(frame, len);
+    #else
+      tx_type = myLora.txBytes(frame, len, TX_CNF);
+    #endif
+    led_off();
+
+    // Leituras só saem dos buffers se o pacote foi transmitido; em erro vão no próximo pacote
+    if (tx_type == TX_SUCCESS || tx_type == TX_WITH_RX)
+      SampleBatch::commit(rings, n, counts);
+
+    // Trata o resultado da transmissão
+    tx_check(tx_type);
+}
+#endif
+
+// ***************************************************************************************************
+// *  Função: tx_check                                                                               *
+// *  Descrição: Função para tratamento do resultado de uma transmissão                              *
+// *  Argumentos: Tipo de retorno da transmissão                                                     *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void tx_check(TX_RETURN_TYPE tx_type)
+{
+    #if (DEBUG==ON && LORA_HOP==ON)
+      myLora.channelStats(Serial);
+    #endif
+
+    #if (DEBUG==ON && TX_CNF==AUTO)
+      Serial.print(F("Perda estimada: "));
+      Serial.print(myLora.getLossRate());
+      Serial.print(F("%, Margem: "));
+      Serial.print(myLora.getMargin());
+      Serial.println(F(" dB"));
+    #endif
+
     // Checa o resultado da transmissão
     // Houve ERRO
     if(tx_type!=TX_SUCCESS && tx_type!=TX_WITH_RX)
@@ -358,6 +532,8 @@ void tx_payload(String payload)
         {
           Serial.print(F("Resposta RX: "));
           Serial.println(myLora.getRxMessenge());
+          if (myLora.rxTruncated())
+            Serial.println(F("Resposta RX maior que RN2903_RX_MAX: cortada"));
         }
       #endif  
       // Zera contador de erros
@@ -392,30 +568,51 @@ void initialize_rn2903(void)
   // Reseta o módulo
   myLora.factoryReset();
 
+  // Número de comandos enviados em sequência pela fila
+  myLora.setWindow(LORA_WINDOW);
+
   // Limpa dados recebidos na porta serial
   LoraSerial.flush();
   Serial.flush();
 
-  // Configura parâmetros do Modulo RN2903:
-  myLora.setParams( 0,              // Índice da sub-banda
-                    LORA_DR,        // DR (AU => 0=SF12, 1=SF11, 2=SF10, 3=SF9, 4=SF8, 5=SF7)
-                    255,            // 0 (SINGLE CHANNEL - 902.3MHz) / 255 = Sub-band
-                    LORA_ADR,       // ADR - Adaptative Data Rate
-                    LORA_REP,       // Número de tentativas de retransmissões automáticas
-                    DEBUG_RN2903,   // Deve ou não debugar na porta Serial
-                    LORA_AR,        // Liga a repetição automática
-                    LORA_PW         // Potência inicial do Rádio 
-                    ); 
+  // Configura parâmetros do Modulo RN2903 (com perfil, já definidos em tempo de compilação):
+  #if (LORA_PROFILE==OFF)
+    myLora.setParams( LORA_SB,        // Índice da sub-banda
+                      LORA_DR,        // DR (AU => 0=SF12, 1=SF11, 2=SF10, 3=SF9, 4=SF8, 5=SF7)
+                      LORA_CH,        // 0 (SINGLE CHANNEL - 902.3MHz) / 255 = Sub-band
+                      LORA_ADR,       // ADR - Adaptative Data Rate
+                      LORA_REP,       // Número de tentativas de retransmissões automáticas
+                      DEBUG_RN2903,   // Deve ou não debugar na porta Serial
+                      LORA_AR,        // Liga a repetição automática
+                      LORA_PW         // Potência inicial do Rádio 
+                      ); 
+  #endif
+
+  // Configura a política de confirmação adaptativa
+  myLora.setCnfPolicy(CNF_EVERY, CNF_LOSS, CNF_MARGIN);
                     
   // Inicializa parâmetros para executar JOIN conforme tipo de ativação
-  #if (ACTIVATION==OTAA)
-    myLora.setJoin(APPEUI, APPKEY, DEVEUI, true);
-  #else
-    myLora.setJoin(NWKSKEY, APPSKEY, DEVADDR, false);
+  // Com KEYS_EEPROM, as chaves definidas abaixo só são usadas se a EEPROM ainda não tiver chaves
+  #if (KEYS_EEPROM==ON)
+  if (!myLora.loadKeys(KEYS_ADDR))
+  {
+  #endif
+    #if (ACTIVATION==OTAA)
+      myLora.setJoin(APPEUI, APPKEY, DEVEUI, true);
+    #else
+      myLora.setJoin(NWKSKEY, APPSKEY, DEVADDR, false);
+    #endif
+  #if (KEYS_EEPROM==ON)
+    myLora.saveKeys(KEYS_ADDR);
+  }
   #endif
 
   // Reseta, configura e inicializa o módulo RN2903
-  myLora.init();
+  #if (LORA_PROFILE==ON)
+    myLora.initProfile(rn2903_script, rn2903_chmask, DEBUG_RN2903);
+  #else
+    myLora.init();
+  #endif
 
   #if (DEBUG==ON)
     Serial.print(F("Node: "));
@@ -479,6 +676,16 @@ void initialize_rn2903(void)
   #if (DEBUG==ON)
     Serial.println(F("Sucesso de JOIN com a rede."));
   #endif
+
+  // Seleção dinâmica dos canais da sub-banda conforme os resultados das transmissões
+  #if (LORA_HOP==ON)
+    myLora.setHopping(LORA_SB, HOP_MIN, HOP_EPOCH);
+  #endif
+
+  // Link Check periódico para acompanhar a margem do enlace (o driver o reenvia após cada reset/join)
+  #if (TX_CNF==AUTO)
+    myLora.setLinkCheck(LINK_CHECK);
+  #endif
 }
 
 #endif
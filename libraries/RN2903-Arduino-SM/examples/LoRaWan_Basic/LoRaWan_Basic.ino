@@ -14,6 +14,8 @@
 // *  Arquivos de include básicos                                                                    *  
 // ***************************************************************************************************
 #include <avr/wdt.h>          // Biblioteca do WatchDog Timer do Microcontrolador AVR
+#include <AdcScan.h>          // Leitura das entradas analógicas em segundo plano (interrupção do ADC)
+#include <FreeRam.h>          // RAM livre entre heap e pilha (atual e mínima desde o reset)
 
 // ***************************************************************************************************
 // *  Definições auxiliares                                                                          *
@@ -31,26 +33,49 @@
 #define DHT22         OFF       // Uso do sensor DHT22
 #define COUNTER       OFF       // Uso do sensor de presença
 
-#define PRESCALE      900       // Constante de tempo do prescale (1 segundo)   
 #define BASE_TIME     30        // Tempo entre transmissões automáticas (s), 0 = Não transmite
-#define DEB_BT        10        // Debounce para Contador
-#define DEB_CT        10        // Debounce para Botões
+#define POLL_TIME     8         // Tempo entre leituras dos botões (ms)
+#define DEB_BT        2         // Debounce para Botões (número de leituras)
+#define DEB_CT        5         // Debounce para Contador (ms entre pulsos contados)
 #define DEBUG         ON        // Imprime mensagens de Debug
 
+#define BATCH         OFF       // Acumula leituras e transmite em lote delta-codificado (SampleBatch)
+#define SAMPLE_TIME   30        // Tempo entre leituras acumuladas (s)
+#define BATCH_SIZE    8         // Número de leituras guardadas por variável
+#define BATCH_MAX     48        // Tamanho máximo do pacote (bytes), conforme o DR utilizado
+
+#if (BATCH==ON && DHT22==OFF && COUNTER==OFF)
+  #error (Envio em lote exige DHT22 ou COUNTER)
+#endif
+
 // ***************************************************************************************************
 // *  Definição da pinagem                                                                           *
 // ***************************************************************************************************
 // Digitais
 #if (LORA==ON)
-  #if (ARDUINO==UNO)
+  #if (ARDUINO==UNO && COUNTER==OFF)
     #define RX_PIN        2       // Pino RX ligado no RN2903
     #define TX_PIN        3       // Pino TX ligado no RN2903
                                   // ATENÇÃO: NO CASO DO MEGA, LIGAR RX no PINO 19 e TX no PINO 18
+  #elif (ARDUINO==UNO)
+    // O contador precisa do pino 2 (interrupção externa): a SoftwareSerial vai para os pinos 8 e 9
+    // (a recepção só precisa de interrupção por mudança de pino, presente em todos os pinos do UNO).
+    // ATENÇÃO: ligar com jumpers o RX do RN2903 (pino 2 do shield) no pino 8 e o TX (pino 3) no 9
+    #define RX_PIN        8       // Pino RX ligado no RN2903
+    #define TX_PIN        9       // Pino TX ligado no RN2903
   #endif
   #define LORA_RST_PIN    4       // Pino RESET ligado no RN2903
 #endif
 #if (COUNTER==ON)
-  #define CNT_PIN         5       // Pino ligado no módulo do contador
+  #define CNT_PIN         2       // Pino ligado no módulo do contador (precisa de interrupção externa)
+  #if (ARDUINO==UNO && CNT_PIN!=2 && CNT_PIN!=3)
+    #error (CNT_PIN precisa de interrupção externa: no UNO pinos 2 ou 3)
+  #elif (ARDUINO==MEGA && CNT_PIN!=2 && CNT_PIN!=3 && CNT_PIN!=20 && CNT_PIN!=21)
+    #error (CNT_PIN precisa de interrupção externa: no MEGA pinos 2, 3, 20 ou 21)
+  #endif
+  #if (LORA==ON && ARDUINO==UNO && (CNT_PIN==RX_PIN || CNT_PIN==TX_PIN))
+    #error (CNT_PIN coincide com RX_PIN/TX_PIN da SoftwareSerial)
+  #endif
 #endif
 #if (DHT22==ON)
   #define DHT_PIN         6       // Pino de comuniação com o DHT22
@@ -68,16 +93,26 @@ int  num_bt = 0;                // Contador do número de vezes que 1 botão é
 byte b_filter = 5;              // Filtro para detecção do botão
 byte num;                       // Número randômico
 bool sw=0;                      // Switch (invertido a cada botão pressionado)
-int  prescaler = PRESCALE;      // Contador de presscaler para base de tempo
-int  base_time = BASE_TIME;     // Contador de tempo para transmissão base de tempo (1 seg)
+byte bt_adc;                    // Índice dos botões na varredura do ADC
+
+// ***************************************************************************************************
+// *  Variáveis do Timer2  (Temporizador)                                                            *
+// ***************************************************************************************************
+byte t2_ps;                     // Prescalar do Timer2 para contagem de 1 segundo
+bool t2_fs;                     // Flag indicando que passou 1 segundo
+bool t2_fm;                     // Flag indicando que passou 1 minuto
+bool t2_fh;                     // Flag indicando que passou 1 hora
+byte t2_seg;                    // Contador de segundos
+byte t2_min;                    // Contador de minutos
+volatile unsigned long t2_ms;   // Contador de milissegundos (base do agendador de tarefas)
 
 // ***************************************************************************************************
 // *  Variáveis do contador (sensor de presença)                                                     *
 // ***************************************************************************************************
 #if (COUNTER==ON)
-  bool counter_sensor;          // Flag do sensor contador
-  int  counter = 0;             // Acumulador do sensor contador 
-  byte c_filter = 5;            // Filtro de leitura do sensor contador
+  #include <PulseCounter.h>     // Contagem dos pulsos por interrupção externa
+  unsigned int counter = 0;     // Acumulador do sensor contador 
+  byte cnt_input;               // Índice do contador na biblioteca PulseCounter
 #endif
 
 // ***************************************************************************************************
@@ -85,11 +120,29 @@ int  base_time = BASE_TIME;     // Contador de tempo para transmissão base de t
 // ***************************************************************************************************
 #if (DHT22==ON)
   #include <SimpleDHT.h>
-  float temperature = 0;        // Valor da temperatura
-  float humidity = 0;           // Valor da umidade
+  #include <FixedPoint.h>       // Conversão e texto em ponto fixo (sem float)
+  int temperature = 0;          // Valor da temperatura (centésimos de °C)
+  int humidity = 0;             // Valor da umidade (centésimos de %)
   SimpleDHT22 dht22(DHT_PIN);   // Cria instância para o sensor vinculado ao pino correto
 #endif
 
+// ***************************************************************************************************
+// *  Acumuladores das leituras para envio em lote                                                   *
+// ***************************************************************************************************
+#if (BATCH==ON)
+  #include <SampleBatch.h>
+  #if (DHT22==ON)
+    sb_sample temp_buf[BATCH_SIZE];
+    sb_sample humi_buf[BATCH_SIZE];
+    SampleRing temp_ring(4, 1, temp_buf, BATCH_SIZE);       // Id 4 (alias A4), 1 casa decimal
+    SampleRing humi_ring(5, 1, humi_buf, BATCH_SIZE);       // Id 5 (alias A5), 1 casa decimal
+  #endif
+  #if (COUNTER==ON)
+    sb_sample counter_buf[BATCH_SIZE];
+    SampleRing counter_ring(6, 0, counter_buf, BATCH_SIZE); // Id 6 (alias A6), inteiro
+  #endif
+#endif
+
 // ***************************************************************************************************
 // *  Variáveis do RN2903 para transmissão no payload                                                *
 // ***************************************************************************************************
@@ -122,8 +175,11 @@ int  base_time = BASE_TIME;     // Contador de tempo para transmissão base de t
 // ***************************************************************************************************
 byte read_button(void)
 {
-  // Efetua leitura analógica do pino dos botôes
-  int leitura = analogRead(BT_PIN);
+  // Nenhum resultado do ADC ainda
+  if (AdcScan::available(bt_adc) == 0) return 0;
+
+  // Última leitura filtrada do pino dos botões (12 bits convertidos para a escala de 10 bits)
+  int leitura = AdcScan::read(bt_adc) >> 2;
 
   // Checa valor da tensão devido aos divisores resistivos dos botões
   if(leitura < 120){
@@ -236,7 +292,7 @@ void time_auto(void)
   // Leitura do Sensor de Temperatura e Umidade DHT22 - Grava valores em temperature e humidity
   #if (DHT22==ON)
     int err = SimpleDHTErrSuccess;
-    if ((err = dht22.read2(&temperature, &humidity, NULL)) != SimpleDHTErrSuccess)
+    if ((err = read_dht()) != SimpleDHTErrSuccess)
     {
       #if (DEBUG==ON)
         Serial.print(F("Leitura do DHT22 falhou, err=")); Serial.println(err);delay(2000);
@@ -256,11 +312,62 @@ void time_auto(void)
   #endif  
 
   #if (DEBUG==ON)
+    // Menor RAM livre desde o reset: margem real da pilha + heap
+    Serial.print(F("RAM livre: ")); Serial.print(FreeRam::current());
+    Serial.print(F(" bytes, minima: ")); Serial.println(FreeRam::lowest());
     Serial.println(F("*******************************"));
   #endif
 
 }
 
+// ***************************************************************************************************
+// *  Função: read_dht                                                                               *
+// *  Descrição: Leitura do DHT22 em ponto fixo (bits decodificados sem float)                       *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Código de erro da SimpleDHT (temperature e humidity mantidas em caso de erro)         *
+// ***************************************************************************************************
+#if (DHT22==ON)
+int read_dht(void)
+{
+  byte bits[40];
+  int t, h;
+
+  int err = dht22.read(NULL, NULL, bits);
+  if (err != SimpleDHTErrSuccess) return err;
+  if (!FixedPoint::dht22(bits, &t, &h)) return SimpleDHTErrDataChecksum;
+
+  // Décimos para centésimos
+  temperature = t * 10;
+  humidity = h * 10;
+  return SimpleDHTErrSuccess;
+}
+#endif
+
+// ***************************************************************************************************
+// *  Função: read_samples                                                                           *
+// *  Descrição: Tarefa de leitura dos sensores para envio em lote (a cada SAMPLE_TIME s)            *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+#if (BATCH==ON)
+void read_samples(void)
+{
+  unsigned long now = t2_millis() / 1000;
+
+  #if (DHT22==ON)
+    if (read_dht() == SimpleDHTErrSuccess)
+    {
+      temp_ring.addRaw(FixedPoint::rescale(temperature, 2, 1), now);
+      humi_ring.addRaw(FixedPoint::rescale(humidity, 2, 1), now);
+    }
+  #endif
+  #if (COUNTER==ON)
+    update_counter();
+    counter_ring.addRaw(counter, now);
+  #endif
+}
+#endif
+
 // ***************************************************************************************************
 // *  Função: setup (obrigatória)                                                                    *
 // *  Descrição: Função de inicialização do sistema (após energização ou reset)                      *
@@ -278,12 +385,18 @@ void setup(void)
   #endif
   #if (COUNTER==ON)
     pinMode(CNT_PIN, INPUT_PULLUP);             //Habilita porta como saída
+    cnt_input = PulseCounter::add(CNT_PIN, DEB_CT * 1000UL, FALLING);  // Conta as bordas de descida
   #endif
   #if (LORA==ON)
     pinMode(LORA_RST_PIN, OUTPUT);              //Habilita porta como saída
   #endif
   pinMode(LED1_PIN, OUTPUT);                  //Habilita porta como saída
 
+  // Varredura do ADC para os botões: uma conversão a cada estouro do Timer0, mediana dos
+  // últimos resultados (descarta leituras no meio da transição entre os níveis dos botões)
+  bt_adc = AdcScan::add(BT_PIN, AS_MEDIAN);
+  AdcScan::begin(AS_TIMER0);
+
   // Cria uma semente para o gerador de números randômicos
   randomSeed(500);
   
@@ -295,7 +408,7 @@ void setup(void)
 
   // Primeira leitura do DHT22 para iniciar o HW
   #if (DHT22==ON)
-    dht22.read2(&temperature, &humidity, NULL);
+    read_dht();
   #endif
   
   #if (LORA==ON)
@@ -309,6 +422,16 @@ void setup(void)
     initialize_rn2903();
   #endif
 
+  // Configura Timer2 e agenda as tarefas periódicas
+  setupTimer2();
+  #if (BASE_TIME > 0 && LORA==ON)
+    t2_every(time_auto, BASE_TIME * 1000UL, 0);   // Base de tempo das transmissões automáticas
+  #endif
+  t2_every(read_inputs, POLL_TIME, 0);           // Leitura dos botões
+  #if (BATCH==ON)
+    t2_every(read_samples, SAMPLE_TIME * 1000UL, 0); // Leituras acumuladas para envio em lote
+  #endif
+
   #if (DEBUG==ON)
     Serial.println(F("=== Entrando em Operação Normal ==="));
   #endif
@@ -316,32 +439,13 @@ void setup(void)
 }
 
 // ***************************************************************************************************
-// *  Função: loop (obrigatória)                                                                     *
-// *  Descrição: Função de looping principal                                                         *
+// *  Função: read_inputs                                                                            *
+// *  Descrição: Tarefa de leitura e filtro dos botões (a cada POLL_TIME ms)                         *
 // *  Argumentos: Nenhum                                                                             *
 // *  Retorno: Nenhum                                                                                *
 // ***************************************************************************************************
-void loop()
+void read_inputs(void)
 {
-  // Reset de WDT
-  wdt_reset();
-
-  // Checa prescaler - Contador de 1 segundo
-  if(prescaler==0){
-    prescaler=PRESCALE;  // Reinicializa prescaler
-    
-    // Checa base de tempo - Múltiplo do prescaler
-    #if (BASE_TIME > 0)
-      if (base_time==0){        
-        base_time = BASE_TIME;  // Reinicia base de tempo
-        #if (LORA==ON)
-          time_auto();          // Executa comandos da base de tempo
-        #endif
-      }
-      base_time--;              // Decrementa contador de tempo
-    #endif
-  }
-  
   // Trata filtro do botão
   #if (RFID==ON)
     if (programMode){
@@ -363,23 +467,33 @@ void loop()
   #if (RFID==ON)
     }
   #endif
+}
 
-  // Trata filtro do contador
-  #if (COUNTER==1)
-    if (counter_sensor==0 && counter_sensor==digitalRead(CNT_PIN)){
-      if(c_filter==0) {
-        counter++;          // Incrementa contador
-        c_filter=255;
-      } else {
-        if (c_filter!=255)c_filter--;      
-      }
-    } else {
-      counter_sensor==digitalRead(CNT_PIN);  // Lê sendor de presença
-      c_filter=DEB_CT;
-    }    
-  #endif    
-  
-  // Delay multiplo do prescaler
-  delay(1);
-  prescaler--;
+// ***************************************************************************************************
+// *  Função: update_counter                                                                         *
+// *  Descrição: Soma no contador os pulsos contados pela interrupção desde a última chamada         *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+#if (COUNTER==ON)
+void update_counter(void)
+{
+  // Leitura e zeramento atômicos: nenhum pulso se perde entre as chamadas
+  counter += PulseCounter::take(cnt_input);
+}
+#endif
+
+// ***************************************************************************************************
+// *  Função: loop (obrigatória)                                                                     *
+// *  Descrição: Função de looping principal                                                         *
+// *  Argumentos: Nenhum                                                                             *
+// *  Retorno: Nenhum                                                                                *
+// ***************************************************************************************************
+void loop()
+{
+  // Reset de WDT
+  wdt_reset();
+
+  // Executa as tarefas com prazo vencido (base de tempo e leitura das entradas)
+  t2_run();
 }
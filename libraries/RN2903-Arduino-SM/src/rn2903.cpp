@@ -16,6 +16,10 @@ extern "C" {
 #include <stdlib.h>
 }
 
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
 //==========================================================================
 rn2903::rn2903(Stream& serial, byte resetPin):
 _serial(serial)
@@ -79,7 +83,6 @@ void rn2903::setParams(byte sb, byte dr, byte ch, bool adr, byte retx, byte debu
 bool rn2903::configParams(void)
 {
 	bool chOn;
-    String receivedData;
 	String command;
     _serial.setTimeout(5000);
 
@@ -105,11 +108,11 @@ bool rn2903::configParams(void)
 		command += channel;			
 		if(chOn)	
 		{
-			sendRawCommand(command+F(" on"));
+			queue(command+F(" on"));
 		}
 		else
 		{
-			sendRawCommand(command+F(" off"));
+			queue(command+F(" off"));
 		}
 	}  
 
@@ -119,88 +122,152 @@ bool rn2903::configParams(void)
 	// Set Adaptive Data Rate.
 	if(_adr)	
 	{
-		sendRawCommand(F("mac set adr on"));
+		queue(F("mac set adr on"));
 	}
 	else
 	{
-		sendRawCommand(F("mac set adr off"));
+		queue(F("mac set adr off"));
 	}
 
 	// Set Automatic Reply.
 	if(_ar)	
 	{
-		sendRawCommand(F("mac set ar on"));
+		queue(F("mac set ar on"));
 	}
 	else
 	{
-		sendRawCommand(F("mac set ar off"));
+		queue(F("mac set ar off"));
 	}
 
 	// Set DR and freq for RX2
-	sendRawCommand(F("mac set rx2 8 923300000"));
-	sendRawCommand(F("mac set rxdelay1 1000"));
+	queue(F("mac set rx2 8 923300000"));
+	queue(F("mac set rxdelay1 1000"));
 	
 	
 	// Set Data Rate
 	command = "mac set dr ";
 	command += _dr;
-	sendRawCommand(command);
+	queue(command);
 	
 	// Set Number of Retransmissions
 	command = F("mac set retx ");
 	command += _retx;
-	sendRawCommand(command);
+	queue(command);
 
     // Set the power TX
  	command = F("mac set pwridx ");
 	command += _pw;
-	sendRawCommand(command);
+	queue(command);
 
 	// set join parameters
+	configKeys();
+
+	return true;
+}
+
+//==========================================================================
+void rn2903::configKeys(void)
+{
 	if (_otaa)
 	{
-		command = "mac set deveui ";
-		command += _deveui;
-		receivedData = sendRawCommand(command);
-		command = "mac set appeui ";
-		command += _appeui;
-		receivedData = sendRawCommand(command);
-		command = "mac set appkey ";
-		command += _appkey;
-		receivedData = sendRawCommand(command);
-
+		sendKey(F("mac set deveui "), _deveui, 8);
+		sendKey(F("mac set appeui "), _appeui, 8);
+		sendKey(F("mac set appkey "), _appkey, 16);
 	} else {
-		command = "mac set devaddr ";
-		command += _deveui;
-		receivedData = sendRawCommand(command);
-		command = "mac set nwkskey ";
-		command += _appeui;
-		receivedData = sendRawCommand(command);
-		command = "mac set appskey ";
-		command += _appkey;
-		receivedData = sendRawCommand(command);
+		sendKey(F("mac set devaddr "), _deveui, 4);
+		sendKey(F("mac set nwkskey "), _appeui, 16);
+		sendKey(F("mac set appskey "), _appkey, 16);
 	}
-
-	return true;
 }
 
+//==========================================================================
+void rn2903::sendKey(const __FlashStringHelper* command, const byte* key, uint8_t size)
+{
+  char buffer[3];
+
+  rawStart();
+
+  // Key is hex-encoded while being sent, no text copy is kept in RAM
+  _serial.print(command);
+  for (uint8_t i=0; i<size; i++)
+  {
+    sprintf(buffer, "%02X", key[i]);
+    _serial.print(buffer);
+  }
+  _serial.println();
+
+  rawReply();
+}
 
 //==========================================================================
-void rn2903::setJoin(String AppEUI, String AppKey, String DevEUI="", bool otaa=true)
+void rn2903::setJoin(String AppEUI, String AppKey, String DevEUI, bool otaa)
 {
   _otaa = otaa;
-  _appeui = AppEUI;
-  _appkey = AppKey;
-  _deveui = DevEUI;
- 
+  memset(_deveui, 0, sizeof(_deveui));
+  memset(_appeui, 0, sizeof(_appeui));
+  memset(_appkey, 0, sizeof(_appkey));
+
+  hexToBytes(AppEUI, _appeui, _otaa ? 8 : 16);
+  hexToBytes(AppKey, _appkey, 16);
+
   if (_otaa){
 	  if (DevEUI.length() != 16)
 	  {
-		_deveui = sendRawCommand(F("sys get hweui"));
+		DevEUI = sendRawCommand(F("sys get hweui"));
 	  }
+	  hexToBytes(DevEUI, _deveui, 8);
+  } else {
+	  hexToBytes(DevEUI, _deveui, 4);
+  }
+}
+
+//==========================================================================
+void rn2903::setJoin(const byte* appEui, const byte* appKey, const byte* devEui, bool otaa)
+{
+  _otaa = otaa;
+  memset(_deveui, 0, sizeof(_deveui));
+  memset(_appeui, 0, sizeof(_appeui));
+  memcpy(_appeui, appEui, _otaa ? 8 : 16);
+  memcpy(_appkey, appKey, 16);
+
+  if (devEui != NULL)
+  {
+	  memcpy(_deveui, devEui, _otaa ? 8 : 4);
+  }
+  else if (_otaa)
+  {
+	  hexToBytes(sendRawCommand(F("sys get hweui")), _deveui, 8);
   }
 }
 
+//==========================================================================
+void rn2903::saveKeys(int addr)
+{
+#if defined(__AVR__)
+  eeprom_update_byte((uint8_t*)addr, RN2903_EE_MAGIC);
+  eeprom_update_byte((uint8_t*)(addr+1), _otaa);
+  eeprom_update_block(_deveui, (void*)(addr+2), sizeof(_deveui));
+  eeprom_update_block(_appeui, (void*)(addr+10), sizeof(_appeui));
+  eeprom_update_block(_appkey, (void*)(addr+26), sizeof(_appkey));
+#endif
+}
+
+//==========================================================================
+bool rn2903::loadKeys(int addr)
+{
+#if defined(__AVR__)
+  if (eeprom_read_byte((const uint8_t*)addr) != RN2903_EE_MAGIC)
+    return false;
+
+  _otaa = eeprom_read_byte((const uint8_t*)(addr+1));
+  eeprom_read_block(_deveui, (const void*)(addr+2), sizeof(_deveui));
+  eeprom_read_block(_appeui, (const void*)(addr+10), sizeof(_appeui));
+  eeprom_read_block(_appkey, (const void*)(addr+26), sizeof(_appkey));
+  return true;
+#else
+  return false;
+#endif
+}
 
 //==========================================================================
 void rn2903::init(void)
@@ -212,6 +279,9 @@ void rn2903::init(void)
   while(_serial.available())
     _serial.read();
 
+  // New session: the old estimate does not apply
+  linkReset();
+
   // Config all parameters 
   configParams();
   
@@ -222,6 +292,65 @@ void rn2903::init(void)
   _serial.setTimeout(2000);
 }
 
+//==========================================================================
+void rn2903::initProfile(const char* script, const byte* chMask, byte dbg)
+{
+  String receivedData;
+  byte ticket;
+  char c;
+
+  _debug = dbg;
+  debug("Configure Profile");
+
+  // New session: the old estimate does not apply
+  linkReset();
+
+  //clear serial buffer
+  while(_serial.available())
+    _serial.read();
+
+  _serial.setTimeout(5000);
+
+  // Channel plan decided at compile time, written straight to the module
+  for(byte channel = 0; channel < 72; channel++)
+  {
+    ticket = queueStart(false);
+    _serial.print(F("mac set ch status "));
+    _serial.print(channel);
+    if(pgm_read_byte(chMask + (channel >> 3)) & (1 << (channel & 7)))
+    {
+      _serial.println(F(" on"));
+    }
+    else
+    {
+      _serial.println(F(" off"));
+    }
+    queueEnd(ticket);
+  }
+
+  // Replay the precomputed commands, one line at a time from flash
+  while(pgm_read_byte(script) != 0)
+  {
+    ticket = queueStart(false);
+    while((c = pgm_read_byte(script)) != 0)
+    {
+      script++;
+      if(c == '\n') break;
+      _serial.write((byte)c);
+    }
+    _serial.println();
+    queueEnd(ticket);
+  }
+
+  // Join keys are only known at run time
+  configKeys();
+
+  receivedData = sendRawCommand(F("mac save"));
+  debug("Init Save: ",receivedData);
+
+  _serial.setTimeout(2000);
+}
+
 //==========================================================================
 bool rn2903::join()
 {
@@ -303,19 +432,19 @@ String rn2903::hweui(void)
 //==========================================================================
 String rn2903::appeui(void)
 {
-  return _appeui;
+  return bytesToHex(_appeui, _otaa ? 8 : 16);
 }
 
 //==========================================================================
 String rn2903::appkey(void)
 {
-  return _appkey;
+  return bytesToHex(_appkey, 16);
 }
 
 //==========================================================================
 String rn2903::deveui(void)
 {
-  return _deveui;
+  return bytesToHex(_deveui, _otaa ? 8 : 4);
 }
 
 //==========================================================================
@@ -348,6 +477,9 @@ String rn2903::macReset(void)
 //==========================================================================
 void rn2903::pinReset(void)
 {
+  // The module reloads the saved channel mask (whole sub-band, saved by init())
+  _hopCur = 255;
+  _hopOn = 0xFF;
   {
 	digitalWrite(_resetPin, LOW);      // Pino de RESET = 0
 	delay(500);                        // Aguarda 500ms
@@ -355,12 +487,31 @@ void rn2903::pinReset(void)
 	delay(500);                        // Aguarda 500ms
 	debug(F("Reset de Pino do RN2903 com Autobaud"));
   } while(autobaud()==false);  
+
+  // The reset clears the link check of the module. The loss history and the
+  // margin are kept: txCommand() resets and rejoins after every TX error
+  if (_linkChk != 0)
+    setLinkCheck(_linkChk);
 }
 
 //==========================================================================
 String rn2903::getRx(void)
 {
-  return _rxMessenge;
+  return bytesToHex(_rx, _rxLen);
+}
+
+//==========================================================================
+bool rn2903::rxTruncated(void)
+{
+  return _rxSize > _rxLen;
+}
+
+//==========================================================================
+uint8_t rn2903::getRxBytes(byte* buf, uint8_t size)
+{
+  if (size > _rxLen) size = _rxLen;
+  memcpy(buf, _rx, size);
+  return size;
 }
 
 //==========================================================================
@@ -420,7 +571,9 @@ TX_RETURN_TYPE rn2903::txBytes(const byte* data, uint8_t size, bool cfn)
   }
   command += _port;
   command += " ";
-  return txCommand(command, dataToTx, false);
+  TX_RETURN_TYPE ret = txCommand(command, dataToTx, false);
+  cnfResult(cfn, ret);
+  return ret;
 }
 
 //==========================================================================
@@ -430,7 +583,9 @@ TX_RETURN_TYPE rn2903::txCnf(String data)
   command = "mac tx cnf ";
   command += _port;
   command += " ";
-  return txCommand(command, data, true);
+  TX_RETURN_TYPE ret = txCommand(command, data, true);
+  cnfResult(true, ret);
+  return ret;
 }
 
 //==========================================================================
@@ -440,10 +595,318 @@ TX_RETURN_TYPE rn2903::txUncnf(String data)
   command = "mac tx uncnf ";
   command += _port;
   command += " ";
-  return txCommand(command, data, true);
+  TX_RETURN_TYPE ret = txCommand(command, data, true);
+  cnfResult(false, ret);
+  return ret;
 }
 
 
+//==========================================================================
+void rn2903::setCnfPolicy(byte every, byte lossLimit, byte minMargin)
+{
+  if (every == 0) every = 1;
+  _cnfEvery = every;
+  _lossLimit = lossLimit;
+  _minMargin = minMargin;
+}
+
+//==========================================================================
+void rn2903::setLinkCheck(unsigned int sec)
+{
+  _linkChk = sec;
+  String command = F("mac set linkchk ");
+  command += sec;
+  sendRawCommand(command);
+}
+
+//==========================================================================
+void rn2903::linkReset(void)
+{
+  _margin = 255;
+  _cnfHist = 0;
+  _cnfCount = 0;
+  _cnfSince = 0;
+}
+
+//==========================================================================
+bool rn2903::cnfNext(void)
+{
+  // Not enough history: confirm to build the estimate
+  if (_cnfCount < RN2903_CNF_MIN) return true;
+
+  // Periodic confirmation keeps the estimate up to date
+  if (_cnfSince + 1 >= _cnfEvery) return true;
+
+  // Link degraded
+  if (getLossRate() > _lossLimit) return true;
+  if (_margin != 255 && _margin < _minMargin) return true;
+
+  return false;
+}
+
+//==========================================================================
+byte rn2903::getLossRate(void)
+{
+  if (_cnfCount == 0) return 0;
+
+  byte acked = 0;
+  for (byte i=0; i<_cnfCount; i++)
+  {
+    if (_cnfHist & (1u << i)) acked++;
+  }
+  return (byte)(((unsigned int)(_cnfCount - acked) * 100) / _cnfCount);
+}
+
+//==========================================================================
+byte rn2903::getMargin(void)
+{
+  return _margin;
+}
+
+//==========================================================================
+void rn2903::cnfResult(bool cnf, TX_RETURN_TYPE ret)
+{
+  if (!cnf)
+  {
+    if (_cnfSince < 255) _cnfSince++;
+    return;
+  }
+  bool periodic = (_cnfSince + 1 >= _cnfEvery);
+  _cnfSince = 0;
+
+  // Only frames that reached the radio count for the loss estimate
+  // (TX_FAIL_TIMES after only no_free_ch / busy never went on air)
+  if (ret == TX_FAIL_LEN || ret == TX_FAIL_PARAM) return;
+  if (ret == TX_FAIL_TIMES && !_txAir) return;
+
+  bool acked = (ret == TX_SUCCESS || ret == TX_WITH_RX);
+  _cnfHist = (_cnfHist << 1) | (acked ? 1 : 0);
+  if (_cnfCount < RN2903_CNF_WINDOW) _cnfCount++;
+
+  // Margin from the last link check answer (255 if none was received).
+  // Read only with the link check enabled and on the periodic confirmations,
+  // so the degraded-link confirmations do not add a round trip each
+  if (acked && periodic && _linkChk != 0)
+  {
+    String str = sendRawCommand(F("mac get mrgn"));
+    if (str.length() > 0 && isDigit(str.charAt(0)))
+    {
+      _margin = (byte)str.toInt();
+    }
+  }
+  debug("Loss (%): ", String(getLossRate()));
+}
+
+//==========================================================================
+TX_RETURN_TYPE rn2903::txAuto(String data)
+{
+  return tx(data, cnfNext());
+}
+
+//==========================================================================
+TX_RETURN_TYPE rn2903::txBytesAuto(const byte* data, uint8_t size)
+{
+  return txBytes(data, size, cnfNext());
+}
+
+//==========================================================================
+bool rn2903::setHopping(byte sb, byte minChannels, byte epoch)
+{
+  if (sb > 7)
+  {
+    // Back to the module selection: enable the whole sub-band again
+    if (_hopSb != 255)
+    {
+      hopMask(0xFF);
+      flushQueue();
+    }
+    _hopSb = 255;
+    return true;
+  }
+
+  // With ADR the network server owns the channel mask (LinkADRReq): the driver
+  // must not rewrite it
+  String adr = sendRawCommand(F("mac get adr"));
+  if (adr.startsWith(F("on")))
+  {
+    debug(F("Hopping disabled: ADR is on"));
+    setHopping(255);
+    return false;
+  }
+
+  if (minChannels < 1) minChannels = 1;
+  if (minChannels > 8) minChannels = 8;
+  if (epoch < RN2903_HOP_EXPLORE) epoch = RN2903_HOP_EXPLORE;
+
+  // Another sub-band: give the old one back to the module first
+  if (_hopSb != 255 && _hopSb != sb) setHopping(255);
+  if (_hopSb == 255)
+  {
+    _hopOn = 0xFF;
+    _hopCur = 255;
+  }
+
+  _hopSb = sb;
+  _hopMin = minChannels;
+  _hopEpoch = epoch;
+  _hopTx = 0;
+  _hopActive = 0xFF;
+  memset(_hopStat, 0, sizeof(_hopStat));
+  return true;
+}
+
+//==========================================================================
+byte rn2903::getChannelMask(void)
+{
+  return _hopActive;
+}
+
+//==========================================================================
+void rn2903::channelStats(Print& out)
+{
+  out.println(F("Canal\tOK\tSemCh\tOcup\tSemACK\tFalha\tNota\tAtivo"));
+  if (_hopSb == 255) return;
+
+  for (byte i=0; i<8; i++)
+  {
+    out.print(_hopSb*8 + i);                       out.print('\t');
+    out.print(_hopStat[i][RN2903_HOP_OK]);         out.print('\t');
+    out.print(_hopStat[i][RN2903_HOP_NOFREE]);     out.print('\t');
+    out.print(_hopStat[i][RN2903_HOP_BUSY]);       out.print('\t');
+    out.print(_hopStat[i][RN2903_HOP_NOACK]);      out.print('\t');
+    out.print(_hopStat[i][RN2903_HOP_FAIL]);       out.print('\t');
+    out.print(hopScore(i));                        out.print('\t');
+    out.println((_hopActive & (1 << i)) ? F("S") : F("N"));
+  }
+}
+
+//==========================================================================
+void rn2903::hopChannel(byte ch, bool on)
+{
+  String command = F("mac set ch status ");
+  command += _hopSb*8 + ch;
+  if (on)
+  {
+    queue(command+F(" on"));
+  }
+  else
+  {
+    queue(command+F(" off"));
+  }
+}
+
+//==========================================================================
+void rn2903::hopNext(void)
+{
+  byte next = (_hopCur == 255) ? 7 : _hopCur;
+
+  // Round robin over the active set, sometimes trying an inactive channel
+  bool explore = (_hopTx % RN2903_HOP_EXPLORE == RN2903_HOP_EXPLORE - 1) && (_hopActive != 0xFF);
+  for (byte i=1; i<=8; i++)
+  {
+    byte ch = (next + i) % 8;
+    bool active = _hopActive & (1 << ch);
+    if (explore ? !active : active)
+    {
+      next = ch;
+      break;
+    }
+  }
+
+  // Only the selected channel stays enabled, so the result belongs to it.
+  // Only the channels that change are written, the new one before the old one
+  // is disabled (two commands per hop, the whole sub-band only after a reset).
+  hopMask(1 << next);
+  _hopCur = next;
+  debug("TX channel: ", String(_hopSb*8 + next));
+}
+
+//==========================================================================
+void rn2903::hopResult(byte result)
+{
+  if (_hopSb == 255 || _hopCur == 255) return;
+
+  if (_hopStat[_hopCur][result] < 255) _hopStat[_hopCur][result]++;
+
+  if (++_hopTx >= _hopEpoch)
+  {
+    hopRank();
+    _hopTx = 0;
+  }
+}
+
+//==========================================================================
+byte rn2903::hopScore(byte ch)
+{
+  unsigned int tries = 0;
+  for (byte r=0; r<RN2903_HOP_RESULTS; r++)
+    tries += _hopStat[ch][r];
+
+  if (tries == 0) return 128;
+  return (byte)(((unsigned int)_hopStat[ch][RN2903_HOP_OK] * 255) / tries);
+}
+
+//==========================================================================
+void rn2903::hopRank(void)
+{
+  byte score[8];
+  byte best = 0;
+  byte active = 0;
+  byte count = 0;
+
+  for (byte i=0; i<8; i++)
+  {
+    score[i] = hopScore(i);
+    if (score[i] > best) best = score[i];
+  }
+
+  // Channels close to the best one stay active
+  for (byte i=0; i<8; i++)
+  {
+    if ((unsigned int)score[i] * 4 >= (unsigned int)best * 3)
+    {
+      active |= (1 << i);
+      count++;
+    }
+  }
+
+  // Complete the minimum set with the best remaining channels
+  while (count < _hopMin)
+  {
+    byte pick = 255;
+    for (byte i=0; i<8; i++)
+    {
+      if (!(active & (1 << i)) && (pick == 255 || score[i] > score[pick])) pick = i;
+    }
+    active |= (1 << pick);
+    count++;
+  }
+  _hopActive = active;
+
+  // Older results weigh less in the next epoch
+  for (byte i=0; i<8; i++)
+  {
+    for (byte r=0; r<RN2903_HOP_RESULTS; r++)
+      _hopStat[i][r] >>= 1;
+  }
+  debug("Channel mask: ", String(_hopActive, BIN));
+}
+
+//==========================================================================
+void rn2903::hopMask(byte mask)
+{
+  // Enable first, so the sub-band never has all the channels off
+  for (byte i=0; i<8; i++)
+  {
+    if ((mask & ~_hopOn) & (1 << i)) hopChannel(i, true);
+  }
+  for (byte i=0; i<8; i++)
+  {
+    if ((_hopOn & ~mask) & (1 << i)) hopChannel(i, false);
+  }
+  _hopOn = mask;
+}
+
 //==========================================================================
 TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
 {
@@ -451,6 +914,10 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
   uint8_t retry_count = 3;
   String receivedData;
   
+  // Replies of queued commands are read before the buffer is cleared
+  flushQueue();
+  _txAir = false;
+
   while(retry_count!=0)
   {
     //clear serial buffer
@@ -462,6 +929,13 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
 
     debug("UpCtr: ",sendRawCommand(F("mac get upctr")));
 
+    // Channel chosen by the driver
+    if (_hopSb != 255)
+    {
+      hopNext();
+      flushQueue();
+    }
+
 	// Send TX command for RN2903
     _serial.print(command);
 
@@ -484,6 +958,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     // Resposta POSITIVA - Comando TX aceito
 	if(receivedData.startsWith("ok"))
     {
+      _txAir = true;
 	  // 2ª Resposta do RN2903, com timeout bem maior por causa do rádio
 	  _serial.setTimeout(8000);
 	  receivedData = _serial.readStringUntil('\n');
@@ -496,6 +971,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
 	  // Transmissão com sucesso
       if(receivedData.startsWith(F("mac_tx_ok")))
       {
+        hopResult(RN2903_HOP_OK);
         return TX_SUCCESS;
       }
 
@@ -503,13 +979,18 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
       else if(receivedData.startsWith(F("mac_rx")))
       {
         //example: mac_rx 1 54657374696E6720313233
-        _rxMessenge = receivedData.substring(receivedData.indexOf(' ', 7)+1);
+        String hex = receivedData.substring(receivedData.indexOf(' ', 7)+1);
+        hex.trim();
+        _rxLen = hexToBytes(hex, _rx, RN2903_RX_MAX);
+        _rxSize = hex.length() / 2 > 255 ? 255 : hex.length() / 2;
+        hopResult(RN2903_HOP_OK);
         return TX_WITH_RX;
       }
 
 	  // Erro na transmissão - Payload muito grande
       else if(receivedData.startsWith(F("invalid_data_len")))
       {
+        hopResult(RN2903_HOP_FAIL);
         return TX_FAIL_LEN;
       }
 
@@ -518,6 +999,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
       else if(receivedData.startsWith(F("mac_err")))
       {
         debug(F("Erro: TX_MAC_ERR"));
+        hopResult(RN2903_HOP_NOACK);
 		join();
       }
 
@@ -526,6 +1008,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
       else
       {
         debug(F("Erro: TX_TIME_OUT_1"));
+        hopResult(RN2903_HOP_FAIL);
 		join();
 		}
     }
@@ -552,7 +1035,12 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
 	// Aguarda um pouco e tenta novamente
 	else if(receivedData.startsWith(F("no_free_ch")))
     {
-      delay(1000);
+      // With hopping the next try goes to another channel without waiting
+      hopResult(RN2903_HOP_NOFREE);
+      if (_hopSb == 255)
+      {
+        delay(1000);
+      }
       debug(F("Erro: TX_FREE_CH"));
     }
 
@@ -561,6 +1049,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
 	else if(receivedData.startsWith(F("not_joined")))
     {
       debug(F("Erro: TX_NOT_JOINED"));
+      hopResult(RN2903_HOP_FAIL);
       join();
     }
  
@@ -569,6 +1058,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     else if(receivedData.startsWith(F("silent")))
     {
       debug(F("Erro: TX_SILENT"));
+      hopResult(RN2903_HOP_FAIL);
 	  pinReset();
     }
 
@@ -577,6 +1067,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     else if(receivedData.startsWith(F("frame_counter")))
     {
       debug(F("Erro: TX_FRAME_ERR"));
+      hopResult(RN2903_HOP_FAIL);
 	  join();
     }
 
@@ -585,6 +1076,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     else if(receivedData.startsWith(F("mac_paused")))
     {
       debug(F("Erro: TX_MAC_PAUSED"));
+      hopResult(RN2903_HOP_FAIL);
 	  join();
     }
 
@@ -593,6 +1085,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     else if(receivedData.startsWith(F("busy")))
     {
       debug(F("Erro: TX_BUSY"));
+      hopResult(RN2903_HOP_BUSY);
       if(busy_count==0)
       {
         join();
@@ -609,6 +1102,7 @@ TX_RETURN_TYPE rn2903::txCommand(String command, String data, bool shouldEncode)
     {
       //unknown response after mac tx command
       debug(F("Erro: TX_TIME_OUT_2"));
+      hopResult(RN2903_HOP_FAIL);
 	  join();
     }
   }
@@ -631,17 +1125,269 @@ void rn2903::sendEncoded(String input)
 }
 
 
+//==========================================================================
+uint8_t rn2903::hexToBytes(const String& hex, byte* buf, uint8_t size)
+{
+  uint8_t n = 0;
+  byte b = 0;
+  bool high = true;
+
+  for (unsigned i=0; i<hex.length() && n<size; i++)
+  {
+    char c = hex.charAt(i);
+    byte v;
+    if (c >= '0' && c <= '9') v = c - '0';
+    else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+    else continue;
+
+    if (high)
+    {
+      b = v << 4;
+    }
+    else
+    {
+      buf[n++] = b | v;
+    }
+    high = !high;
+  }
+  return n;
+}
+
+//==========================================================================
+String rn2903::bytesToHex(const byte* buf, uint8_t size)
+{
+  char buffer[3];
+  String hex;
+  hex.reserve(size*2);
+  for (uint8_t i=0; i<size; i++)
+  {
+    sprintf(buffer, "%02X", buf[i]);
+    hex += buffer;
+  }
+  return hex;
+}
+
+//==========================================================================
+void rn2903::setWindow(byte window)
+{
+  if (window < 1) window = 1;
+  if (window > RN2903_QUEUE) window = RN2903_QUEUE;
+  _qWindow = window;
+}
+
+//==========================================================================
+byte rn2903::queue(String command, bool keep)
+{
+  byte ticket = queueStart(keep);
+
+  if (ticket == RN2903_NO_TICKET && keep) return ticket;
+  _serial.println(command);
+  queueEnd(ticket);
+  return ticket;
+}
+
+//==========================================================================
+byte rn2903::queueStart(bool keep)
+{
+  byte ticket = RN2903_NO_TICKET;
+
+  // Wait for room in the window
+  while (_qCount >= _qWindow)
+    pollQueue();
+
+  for (byte i=0; i<RN2903_QUEUE; i++)
+  {
+    if (_qState[i] == RN2903_CMD_FREE)
+    {
+      ticket = i;
+      break;
+    }
+  }
+  if (ticket == RN2903_NO_TICKET)
+  {
+    // All tickets kept by the caller: a kept command is not sent (the caller
+    // must check), any other one is sent at once without the queue
+    if (!keep) rawStart();
+    return ticket;
+  }
+
+  // Nothing pending: whatever is in the buffer is not a reply to the queue
+  if (_qCount == 0)
+  {
+    while(_serial.available())
+      _serial.read();
+    _qLen = 0;
+    _qSince = millis();
+  }
+
+  _qState[ticket] = RN2903_CMD_SENT;
+  _qReply[ticket][0] = 0;
+  if (keep)
+  {
+    _qKeep |= (1 << ticket);
+  }
+  else
+  {
+    _qKeep &= ~(1 << ticket);
+  }
+  _qFifo[(_qHead + _qCount) % RN2903_QUEUE] = ticket;
+  _qCount++;
+  return ticket;
+}
+
+//==========================================================================
+void rn2903::queueEnd(byte ticket)
+{
+  if (ticket != RN2903_NO_TICKET) return;
+
+  String reply = rawReply();
+  if (reply.startsWith(F("invalid")))
+  {
+    debug(F("Queue: "), reply);
+  }
+}
+
+//==========================================================================
+void rn2903::pollQueue(void)
+{
+  while (_qCount > 0 && _serial.available())
+  {
+    char c = _serial.read();
+    byte ticket = _qFifo[_qHead];
+
+    if (c == '\n')
+    {
+      _qReply[ticket][_qLen] = 0;
+      queueDone(RN2903_CMD_DONE);
+    }
+    else if (c != '\r' && _qLen < RN2903_REPLY_MAX - 1)
+    {
+      _qReply[ticket][_qLen++] = c;
+    }
+  }
+
+  if (_qCount > 0 && millis() - _qSince > RN2903_REPLY_TIMEOUT)
+  {
+    // A late reply would be taken for the next command: every pending command
+    // fails and the input is discarded up to the reply of a sync command
+    _qReply[_qFifo[_qHead]][_qLen] = 0;
+    while (_qCount > 0)
+      queueDone(RN2903_CMD_TIMEOUT);
+    resync();
+  }
+}
+
+//==========================================================================
+void rn2903::resync(void)
+{
+  // The module answers in order and "sys get ver" has a reply no queued command
+  // has: the late replies are the lines received before it. The whole search is
+  // bounded by one reply timeout, whatever the timeout of the stream is
+  char line[6];
+  byte n = 0;
+  unsigned long t0 = millis();
+
+  _serial.println(F("sys get ver"));
+  while (millis() - t0 < RN2903_REPLY_TIMEOUT)
+  {
+    if (!_serial.available()) continue;
+    char c = _serial.read();
+    if (c == '\n')
+    {
+      if (n == sizeof(line) && strncmp(line, "RN2903", sizeof(line)) == 0) return;
+      n = 0;
+    }
+    else if (n < sizeof(line))
+    {
+      line[n++] = c;
+    }
+  }
+  debug(F("Queue: resync failed"));
+}
+
+//==========================================================================
+void rn2903::queueDone(byte state)
+{
+  byte ticket = _qFifo[_qHead];
+  _qHead = (_qHead + 1) % RN2903_QUEUE;
+  _qCount--;
+  _qLen = 0;
+  _qSince = millis();
+
+  if (_qKeep & (1 << ticket))
+  {
+    _qState[ticket] = state;
+  }
+  else
+  {
+    // Released at once, only errors are reported
+    if (state == RN2903_CMD_TIMEOUT)
+    {
+      debug(F("Queue: timeout"));
+    }
+    else if (strncmp(_qReply[ticket], "invalid", 7) == 0)
+    {
+      debug(F("Queue: "), _qReply[ticket]);
+    }
+    _qState[ticket] = RN2903_CMD_FREE;
+  }
+}
+
+//==========================================================================
+void rn2903::flushQueue(void)
+{
+  while (_qCount > 0)
+    pollQueue();
+}
+
+//==========================================================================
+byte rn2903::cmdStatus(byte ticket)
+{
+  if (ticket >= RN2903_QUEUE) return RN2903_CMD_FREE;
+  return _qState[ticket];
+}
+
+//==========================================================================
+const char* rn2903::cmdReply(byte ticket)
+{
+  if (ticket >= RN2903_QUEUE) return "";
+  return _qReply[ticket];
+}
+
+//==========================================================================
+void rn2903::release(byte ticket)
+{
+  if (ticket >= RN2903_QUEUE || _qState[ticket] == RN2903_CMD_SENT) return;
+  _qState[ticket] = RN2903_CMD_FREE;
+  _qKeep &= ~(1 << ticket);
+}
+
 //==========================================================================
 String rn2903::sendRawCommand(String command)
 {
-  delay(10);
-  // Limpa dados recebidos
-  while(_serial.available())
-    _serial.read();
+  rawStart();
 
   // Envia comando para o RN2903'
   _serial.println(command);
   
+  return rawReply();
+}
+
+//==========================================================================
+void rn2903::rawStart(void)
+{
+  // Replies of queued commands are read before the buffer is cleared
+  flushQueue();
+
+  // Limpa dados recebidos
+  while(_serial.available())
+    _serial.read();
+}
+
+//==========================================================================
+String rn2903::rawReply(void)
+{
   // Aguarda resposta do módulo
   String ret = _serial.readStringUntil('\n');
   ret.trim();
@@ -652,7 +1398,7 @@ String rn2903::sendRawCommand(String command)
 //==========================================================================
 String rn2903::getRxMessenge(void)
 {
-  return _rxMessenge;
+  return getRx();
 }
 
 //==========================================================================
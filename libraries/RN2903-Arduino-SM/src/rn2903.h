@@ -14,6 +14,38 @@
 // Define use the SingleChannel
 // #define SINGLECHANNEL
 
+// Size of the window of confirmed uplinks used to estimate the loss rate (max 16)
+#define RN2903_CNF_WINDOW   16
+// Minimum number of confirmed results in the window before trusting the estimate
+#define RN2903_CNF_MIN      4
+
+// Channel hopping: results recorded per channel of the sub-band
+#define RN2903_HOP_OK       0   // Transmission done (ACKed when confirmed)
+#define RN2903_HOP_NOFREE   1   // no_free_ch
+#define RN2903_HOP_BUSY     2   // busy
+#define RN2903_HOP_NOACK    3   // mac_err (confirmed frame without ACK)
+#define RN2903_HOP_FAIL     4   // Any other failure (timeout, frame_counter, silent, not_joined...)
+#define RN2903_HOP_RESULTS  5
+// One transmission in every N tries a channel out of the active set to keep its stats fresh
+#define RN2903_HOP_EXPLORE  8
+
+// Command queue
+#define RN2903_QUEUE        4     // Number of tickets (maximum window)
+#define RN2903_REPLY_MAX    14    // Reply bytes kept per ticket (including the terminator)
+#define RN2903_REPLY_TIMEOUT 2000 // Time (ms) to wait for each reply
+#define RN2903_NO_TICKET    255   // No free ticket
+#define RN2903_CMD_FREE     0     // Ticket not in use
+#define RN2903_CMD_SENT     1     // Command written, waiting for the reply
+#define RN2903_CMD_DONE     2     // Reply received
+#define RN2903_CMD_TIMEOUT  3     // No reply
+
+// Maximum size of the last downlink payload kept by the library (bytes).
+// Longer downlinks (up to 242 bytes in US915 / AU915) are cut, see rxTruncated().
+#define RN2903_RX_MAX       32
+// EEPROM signature and size of the key block used by saveKeys() / loadKeys()
+#define RN2903_EE_MAGIC     0xA5
+#define RN2903_EE_SIZE      42
+
 #include "Arduino.h"
 
 enum TX_RETURN_TYPE {
@@ -76,6 +108,23 @@ class rn2903
     // =================================================================================================
     void setJoin(String AppEUI, String v, String DevEUI="", bool otaa=true);
 
+    // =================================================================================================
+    // Setup parameter for JOIN from binary keys (same order as above)
+	// OTAA: appEui[8], appKey[16], devEui[8] (NULL = use the hardware EUI)
+	// ABP: nwkSKey[16], appSKey[16], devAddr[4]
+    // =================================================================================================
+    void setJoin(const byte* appEui, const byte* appKey, const byte* devEui, bool otaa=true);
+
+    // =================================================================================================
+    // Store the join keys in the EEPROM (RN2903_EE_SIZE bytes from addr)
+    // =================================================================================================
+    void saveKeys(int addr=0);
+
+    // =================================================================================================
+    // Load the join keys from the EEPROM. Returns false if no keys were saved at addr.
+    // =================================================================================================
+    bool loadKeys(int addr=0);
+
     // =================================================================================================
     // Initialise the rn2903 and join the LoRa network (if applicable).
     // This function can only be called after calling setJOIN()
@@ -84,6 +133,15 @@ class rn2903
     // =================================================================================================
     void init(void);
 
+    // =================================================================================================
+    // Initialise the rn2903 replaying a configuration profile generated at compile time
+    // (see rn2903_profile.h). Replaces setParams() + init().
+	// script = commands in flash separated by '\n'
+	// chMask = channel bitmask in flash (bit n = channel n on, 72 channels)
+	// debug = debug serial port
+    // =================================================================================================
+    void initProfile(const char* script, const byte* chMask, byte debug=0);
+
     // =================================================================================================
     // Execute a Join (OTAA or ABP).
     // =================================================================================================
@@ -156,6 +214,17 @@ class rn2903
     // =================================================================================================
     String getRx(void);
 
+    // =================================================================================================
+    // Copy the last downlink message (binary) to buf. Returns the number of bytes copied.
+    // =================================================================================================
+    uint8_t getRxBytes(byte* buf, uint8_t size);
+
+    // =================================================================================================
+    // True if the last downlink was longer than RN2903_RX_MAX bytes: only the first
+    // RN2903_RX_MAX bytes were kept by getRx() / getRxBytes().
+    // =================================================================================================
+    bool rxTruncated(void);
+
     // =================================================================================================
     // Get the RN2903's RSSI value from the last received frame. Helpful to debug link quality.
     // =================================================================================================
@@ -202,6 +271,73 @@ class rn2903
     // =================================================================================================
     TX_RETURN_TYPE txUncnf(String data);
 
+    // =================================================================================================
+    // Setup the adaptive confirmation policy used by txAuto() and txBytesAuto()
+	// every = request a confirmed uplink at least once every N uplinks
+	// lossLimit = loss rate (%) above which every uplink is confirmed
+	// minMargin = link margin (dB) below which every uplink is confirmed
+    // =================================================================================================
+    void setCnfPolicy(byte every=8, byte lossLimit=20, byte minMargin=5);
+
+    // =================================================================================================
+    // Enable the periodic link check (LinkCheckReq) used to read the link margin.
+	// sec = interval in seconds, 0 = disabled
+	// The interval is kept and sent again after every reset (join() resets the module).
+    // =================================================================================================
+    void setLinkCheck(unsigned int sec);
+
+    // =================================================================================================
+    // Transmit the provided data choosing between confirmed and unconfirmed uplink.
+    // Unconfirmed frames are sent while the link is healthy; a confirmed frame is requested
+    // periodically or when the observed loss rises or the link margin drops.
+    // Parameter is an ascii text string.
+    // =================================================================================================
+    TX_RETURN_TYPE txAuto(String data);
+
+    // =================================================================================================
+    // Same as txAuto() for raw byte encoded data.
+    // =================================================================================================
+    TX_RETURN_TYPE txBytesAuto(const byte* data, uint8_t size);
+
+    // =================================================================================================
+    // Returns true if the adaptive policy wants the next uplink confirmed.
+    // =================================================================================================
+    bool cnfNext(void);
+
+    // =================================================================================================
+    // Returns the estimated uplink loss rate (%) over the last confirmed uplinks.
+    // =================================================================================================
+    byte getLossRate(void);
+
+    // =================================================================================================
+    // Returns the link margin (dB) of the last link check answer. 255 = unknown.
+	// Read from the module on the periodic confirmed uplinks that were ACKed, only with
+	// setLinkCheck() enabled.
+    // =================================================================================================
+    byte getMargin(void);
+
+    // =================================================================================================
+    // Enable the channel selection done by the driver. Each transmission uses one channel of the
+    // sub-band, so success and every failure (no_free_ch, busy, missing ACK, timeouts...) are
+    // recorded per channel. Every epoch transmissions the active set is reduced to the channels
+    // with the best results.
+	// sb = sub-band (0 - 7), 255 = disabled (module selects among the enabled channels)
+	// minChannels = minimum number of channels kept in the active set
+	// epoch = number of transmissions between updates of the active set
+	// Returns false (hopping disabled) if ADR is on: the network server owns the channel mask.
+    // =================================================================================================
+    bool setHopping(byte sb, byte minChannels=3, byte epoch=32);
+
+    // =================================================================================================
+    // Returns the active channel set (bit n = channel sb*8+n).
+    // =================================================================================================
+    byte getChannelMask(void);
+
+    // =================================================================================================
+    // Print the per channel statistics (channel, results, score and active flag).
+    // =================================================================================================
+    void channelStats(Print& out);
+
     // =================================================================================================
     // Transmit the provided data using the provided command.
     //
@@ -212,6 +348,48 @@ class rn2903
     // =================================================================================================
     TX_RETURN_TYPE txCommand(String command, String data, bool shouldEncode);
 
+    // =================================================================================================
+    // Number of queued commands written to the module before the first reply is read.
+	// 1 = one command at a time. Use 1 with SoftwareSerial, which loses data received while
+	// it is transmitting.
+    // =================================================================================================
+    void setWindow(byte window);
+
+    // =================================================================================================
+    // Write a command through the queue. Blocks only while the window is full. The replies are
+    // matched to the commands in FIFO order, so only commands answered with a single line can be
+    // queued (not mac tx / mac join).
+	// keep = false: the ticket is released when the reply arrives
+	// keep = true: status and reply stay available until release()
+	// Returns the ticket, or RN2903_NO_TICKET if all tickets are kept: then a kept command is
+	// NOT sent (check the ticket), any other one is sent at once as sendRawCommand().
+	// When a reply times out, every pending command fails (RN2903_CMD_TIMEOUT) and the input is
+	// discarded up to the reply of "sys get ver", so a late reply is not taken for the reply of
+	// the next command.
+    // =================================================================================================
+    byte queue(String command, bool keep=false);
+
+    // =================================================================================================
+    // Read the replies already received (non-blocking).
+    // =================================================================================================
+    void pollQueue(void);
+
+    // =================================================================================================
+    // Wait for the replies of all queued commands.
+    // =================================================================================================
+    void flushQueue(void);
+
+    // =================================================================================================
+    // Status (RN2903_CMD_*) and reply of a kept ticket.
+    // =================================================================================================
+    byte cmdStatus(byte ticket);
+    const char* cmdReply(byte ticket);
+
+    // =================================================================================================
+    // Release a kept ticket.
+    // =================================================================================================
+    void release(byte ticket);
+
     // =================================================================================================
     // Send a raw command to the rn2903 module.
     // Returns the raw string as received back from the rn2903.
@@ -249,13 +427,91 @@ class rn2903
     //Flags to switch code paths. Default is to use OTAA.
     bool _otaa = true;
 	
-	// Parameters to OTAA / ABP
-    String _deveui = "";		//OTAA = devEUI, ABP = devADDR
-    String _appeui = "";		//OTAA = appeui, ABP = nwkSkey
-    String _appkey = "";		//OTAA = appKey, ABP = appSKey
+	// Parameters to OTAA / ABP (binary, hex-encoded only when sent to the module)
+    byte _deveui[8];			//OTAA = devEUI (8), ABP = devADDR (4)
+    byte _appeui[16];			//OTAA = appeui (8), ABP = nwkSkey (16)
+    byte _appkey[16];			//OTAA = appKey (16), ABP = appSKey (16)
  
-    // The downlink messenge
-    String _rxMessenge = "";
+    // The downlink messenge (binary)
+    byte _rx[RN2903_RX_MAX];
+    uint8_t _rxLen = 0;
+    uint8_t _rxSize = 0;		// Size of the last downlink (may exceed _rxLen)
+
+    // Adaptive confirmation policy
+    uint16_t _cnfHist = 0;		// Results of the last confirmed uplinks (1 = ACK)
+    byte _cnfCount = 0;			// Number of results in _cnfHist
+    byte _cnfEvery = 8;			// Confirm at least once every N uplinks
+    byte _cnfSince = 0;			// Uplinks since the last confirmed one
+    byte _lossLimit = 20;		// Loss rate (%) that forces confirmation
+    byte _minMargin = 5;		// Link margin (dB) that forces confirmation
+    byte _margin = 255;			// Last link margin (dB), 255 = unknown
+    unsigned int _linkChk = 0;		// Link check interval (s), 0 = disabled
+    bool _txAir = false;		// The last txCommand() got the frame on air at least once
+
+    // Channel hopping
+    byte _hopSb = 255;			// Sub-band used for hopping, 255 = disabled
+    byte _hopMin = 3;			// Minimum number of active channels
+    byte _hopEpoch = 32;		// Transmissions between updates of the active set
+    byte _hopTx = 0;			// Transmissions since the last update
+    byte _hopActive = 0xFF;		// Active set (bit n = channel sb*8+n)
+    byte _hopCur = 255;			// Channel (0 - 7) enabled in the module, 255 = unknown
+    byte _hopOn = 0xFF;			// Channels enabled in the module (bit n = channel sb*8+n)
+    byte _hopStat[8][RN2903_HOP_RESULTS];	// Results per channel (RN2903_HOP_*), halved at each update
+
+    // Select and enable the channel for the next transmission
+    void hopNext(void);
+    // Record the result of the last transmission
+    void hopResult(byte result);
+    // Update the active set
+    void hopRank(void);
+    // Success rate of a channel (0 - 255, 128 = no data)
+    byte hopScore(byte ch);
+    // Enable or disable one channel of the sub-band
+    void hopChannel(byte ch, bool on);
+    // Write only the channels whose state differs from mask
+    void hopMask(byte mask);
+
+    // Command queue
+    byte _qWindow = 1;							// Commands written before waiting for a reply
+    byte _qState[RN2903_QUEUE] = {0};			// Status of each ticket (RN2903_CMD_*)
+    byte _qKeep = 0;							// Kept tickets (bit n = ticket n)
+    char _qReply[RN2903_QUEUE][RN2903_REPLY_MAX];	// Reply of each ticket
+    byte _qFifo[RN2903_QUEUE];					// Tickets waiting for a reply, in sending order
+    byte _qHead = 0;							// First ticket in _qFifo
+    byte _qCount = 0;							// Tickets waiting for a reply
+    byte _qLen = 0;								// Bytes received of the current reply
+    unsigned long _qSince = 0;					// Time (ms) the current reply started to be awaited
+
+    // Finish the first ticket waiting for a reply
+    void queueDone(byte state);
+
+    // Take a ticket for a command the caller writes to the module itself, then call
+    // queueEnd(). Without a free ticket the command is sent as a raw command (not when keep).
+    byte queueStart(bool keep);
+    void queueEnd(byte ticket);
+
+    // Discard the late replies after a reply timeout
+    void resync(void);
+
+    // Send the join keys (OTAA or ABP) to the module
+    void configKeys(void);
+
+    // Send a "mac set" command followed by a hex-encoded key
+    void sendKey(const __FlashStringHelper* command, const byte* key, uint8_t size);
+
+    // Start and end of a blocking command (sendRawCommand() and sendKey())
+    void rawStart(void);
+    String rawReply(void);
+
+    // Hex conversion of the keys and downlink messages
+    static uint8_t hexToBytes(const String& hex, byte* buf, uint8_t size);
+    static String bytesToHex(const byte* buf, uint8_t size);
+
+    // Record the result of every uplink for the adaptive policy
+    void cnfResult(bool cnf, TX_RETURN_TYPE ret);
+
+    // Clear the link estimate when the application starts a new session (init / initProfile)
+    void linkReset(void);
 	
 
 };
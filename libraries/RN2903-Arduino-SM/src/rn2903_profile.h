@@ -0,0 +1,117 @@
+//==========================================================================
+// Compile time configuration profile for the RN2903 library.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// Define the profile before including this file (only once, in the sketch):
+//
+//   #define RN2903_SB     0      // Sub-band (0 - 7)
+//   #define RN2903_CH     255    // Single channel (0 - 63). 255 = sub-band
+//   #define RN2903_DR     2      // Data rate (0 - 4)
+//   #define RN2903_ADR    1      // Adaptative data rate (0 / 1)
+//   #define RN2903_AR     0      // Automatic reply (0 / 1)
+//   #define RN2903_RETX   4      // Number of retransmissions
+//   #define RN2903_PW     6      // Power index
+//   #include <rn2903_profile.h>
+//
+// and initialise the module with:
+//
+//   myLora.initProfile(rn2903_script, rn2903_chmask);
+//
+// The command sequence and the 72 channel on/off decisions are generated
+// by the preprocessor and kept in flash: the sketch does not call
+// setParams() / configParams() and initProfile() writes each command
+// straight from flash to the module, without building it in RAM.
+// The library is compiled apart from the sketch and does not see these
+// macros, so the parameter members of the class (7 bytes) still exist and
+// the join mode (OTAA / ABP) is still chosen at run time by setJoin() or
+// loadKeys(), with both branches of configKeys() linked.
+// Values must be plain numbers or macros expanding to plain numbers.
+//
+//==========================================================================
+
+#ifndef rn2903_profile_h
+#define	rn2903_profile_h
+
+#include "Arduino.h"
+
+// Default profile (same defaults as setParams())
+#ifndef RN2903_SB
+  #define RN2903_SB         0
+#endif
+#ifndef RN2903_CH
+  #define RN2903_CH         255
+#endif
+#ifndef RN2903_DR
+  #define RN2903_DR         2
+#endif
+#ifndef RN2903_ADR
+  #define RN2903_ADR        0
+#endif
+#ifndef RN2903_AR
+  #define RN2903_AR         0
+#endif
+#ifndef RN2903_RETX
+  #define RN2903_RETX       4
+#endif
+#ifndef RN2903_PW
+  #define RN2903_PW         6
+#endif
+
+// RX2 window (AU915 / US915 values used by configParams())
+#ifndef RN2903_RX2_DR
+  #define RN2903_RX2_DR     8
+#endif
+#ifndef RN2903_RX2_FREQ
+  #define RN2903_RX2_FREQ   923300000
+#endif
+#ifndef RN2903_RXDELAY1
+  #define RN2903_RXDELAY1   1000
+#endif
+
+// Checks done at compile time instead of setParams()
+#if (RN2903_SB > 7)
+  #error "RN2903_SB must be between 0 and 7"
+#endif
+#if (RN2903_CH > 63 && RN2903_CH != 255)
+  #error "RN2903_CH must be between 0 and 63 or 255"
+#endif
+#if (RN2903_DR > 4)
+  #error "RN2903_DR must be between 0 and 4"
+#endif
+
+// Helpers to turn the profile values into command text
+#define RN2903_STR_(x)      #x
+#define RN2903_STR(x)       RN2903_STR_(x)
+#define RN2903_ONOFF_0      "off"
+#define RN2903_ONOFF_1      "on"
+#define RN2903_ONOFF__(x)   RN2903_ONOFF_##x
+#define RN2903_ONOFF(x)     RN2903_ONOFF__(x)
+
+// =================================================================================================
+// Commands replayed by initProfile(), separated by '\n'
+// =================================================================================================
+const char rn2903_script[] PROGMEM =
+  "mac set adr " RN2903_ONOFF(RN2903_ADR) "\n"
+  "mac set ar " RN2903_ONOFF(RN2903_AR) "\n"
+  "mac set rx2 " RN2903_STR(RN2903_RX2_DR) " " RN2903_STR(RN2903_RX2_FREQ) "\n"
+  "mac set rxdelay1 " RN2903_STR(RN2903_RXDELAY1) "\n"
+  "mac set dr " RN2903_STR(RN2903_DR) "\n"
+  "mac set retx " RN2903_STR(RN2903_RETX) "\n"
+  "mac set pwridx " RN2903_STR(RN2903_PW) "\n";
+
+// =================================================================================================
+// Channel mask: bit n = channel n on (channels 0 - 71)
+// =================================================================================================
+#define RN2903_CHMASK(i) \
+  ((RN2903_CH == 255) ? (((i) == RN2903_SB) ? 0xFF : 0x00) \
+                      : (((i) == RN2903_CH / 8) ? (1 << (RN2903_CH % 8)) : 0x00))
+
+const byte rn2903_chmask[9] PROGMEM = {
+  RN2903_CHMASK(0), RN2903_CHMASK(1), RN2903_CHMASK(2),
+  RN2903_CHMASK(3), RN2903_CHMASK(4), RN2903_CHMASK(5),
+  RN2903_CHMASK(6), RN2903_CHMASK(7), RN2903_CHMASK(8)
+};
+
+#endif
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# ***************************************************************************************************
+# *  Decodificador do pacote em lote (SampleBatch) para uso no servidor                             *
+# *                                                                                                 *
+# *  Uso: decode.py <pacote em hexadecimal> [horário de recepção em segundos Unix]                  *
+# *  Imprime uma linha por amostra: id, horário (ISO 8601, UTC) e valor                             *
+# *                                                                                                 *
+# *  Versão 1.0 - Outubro/2026                                                                      *
+# ***************************************************************************************************
+
+import sys
+import time
+from datetime import datetime, timezone
+
+SB_FORMAT = 0x01
+
+
+def decode_batch(data, rx_time):
+    """Retorna [(id, [(horário, valor), ...]), ...]"""
+    pos = 0
+
+    def varint():
+        nonlocal pos
+        v = shift = 0
+        while True:
+            if pos >= len(data):
+                raise ValueError("pacote truncado")
+            b = data[pos]
+            pos += 1
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def svarint():
+        z = varint()
+        return (z >> 1) ^ -(z & 1)
+
+    if not data or data[0] != SB_FORMAT:
+        raise ValueError("formato desconhecido")
+    pos = 1
+    variables = []
+    while pos < len(data):
+        if pos + 2 > len(data):
+            raise ValueError("pacote truncado")
+        head, n = data[pos], data[pos + 1]
+        pos += 2
+        scale = 10 ** (head >> 6)
+        value = svarint()
+        t = rx_time - varint()
+        samples = [(t, value / scale)]
+        for _ in range(1, n):
+            t += varint()
+            value += svarint()
+            samples.append((t, value / scale))
+        variables.append((head & 0x3F, samples))
+    return variables
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("uso: decode.py <hex> [horario_unix]")
+        return 1
+    rx_time = float(sys.argv[2]) if len(sys.argv) > 2 else time.time()
+    for vid, samples in decode_batch(bytes.fromhex(sys.argv[1]), rx_time):
+        for t, v in samples:
+            ts = datetime.fromtimestamp(t, timezone.utc).isoformat()
+            print("%02d\t%s\t%g" % (vid, ts, v))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
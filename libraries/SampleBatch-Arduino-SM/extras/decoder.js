@@ -0,0 +1,74 @@
+// ***************************************************************************************************
+// *  Decodificador do pacote em lote (SampleBatch) para o servidor de rede / plataforma             *
+// *                                                                                                 *
+// *  decodeBatch(bytes, time): bytes = array de bytes do pacote, time = horário de recepção (Date)  *
+// *  Retorna { variables: [ { id, samples: [ { time, value } ] } ] } ou { errors: [...] }            *
+// *                                                                                                 *
+// *  decodeUplink(input): formato de "payload formatter" (input.bytes, input.recvTime)              *
+// *  hexToBytes(hex): converte o valor recebido via HTTP (texto hexadecimal)                        *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// ***************************************************************************************************
+
+var SB_FORMAT = 0x01;
+
+function decodeBatch(bytes, time) {
+  var pos = 0;
+
+  function varint() {
+    var v = 0, mul = 1, b;
+    do {
+      if (pos >= bytes.length) throw new Error("pacote truncado");
+      b = bytes[pos++];
+      v += (b & 0x7F) * mul;
+      mul *= 128;
+    } while (b & 0x80);
+    return v;
+  }
+
+  function svarint() {
+    var z = varint();
+    return (z % 2) ? -(z + 1) / 2 : z / 2;
+  }
+
+  try {
+    if (bytes.length < 1 || bytes[pos++] !== SB_FORMAT) throw new Error("formato desconhecido");
+    var now = (time || new Date()).getTime();
+    var variables = [];
+
+    while (pos < bytes.length) {
+      if (pos + 2 > bytes.length) throw new Error("pacote truncado");
+      var head = bytes[pos++];
+      var n = bytes[pos++];
+      var scale = Math.pow(10, head >> 6);
+      var value = svarint();
+      var t = now - varint() * 1000;
+      var samples = [{ time: new Date(t), value: value / scale }];
+
+      for (var i = 1; i < n; i++) {
+        t += varint() * 1000;
+        value += svarint();
+        samples.push({ time: new Date(t), value: value / scale });
+      }
+      variables.push({ id: head & 0x3F, samples: samples });
+    }
+    return { variables: variables };
+  } catch (e) {
+    return { errors: [e.message] };
+  }
+}
+
+function hexToBytes(hex) {
+  var bytes = [];
+  for (var i = 0; i + 1 < hex.length; i += 2) bytes.push(parseInt(hex.substr(i, 2), 16));
+  return bytes;
+}
+
+function decodeUplink(input) {
+  var r = decodeBatch(input.bytes, input.recvTime ? new Date(input.recvTime) : new Date());
+  return r.errors ? { errors: r.errors } : { data: r };
+}
+
+if (typeof module !== "undefined") {
+  module.exports = { decodeBatch: decodeBatch, decodeUplink: decodeUplink, hexToBytes: hexToBytes };
+}
@@ -0,0 +1,12 @@
+// ***************************************************************************************************
+// *  Substituto mínimo do Arduino.h para compilar SampleBatch.cpp no PC (extras/roundtrip)          *
+// ***************************************************************************************************
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#endif
@@ -0,0 +1,119 @@
+// ***************************************************************************************************
+// *  Gerador de pacotes para o teste de ida e volta do SampleBatch (codificador x decodificadores)  *
+// *                                                                                                 *
+// *  Acumula amostras aleatórias em vários SampleRing, monta pacotes com SampleBatch::encode() e    *
+// *  imprime cada pacote com as amostras que ele deve conter, calculadas por um modelo simples      *
+// *  (fila por variável). roundtrip.sh decodifica os pacotes com decode.py e decoder.js e compara.  *
+// *                                                                                                 *
+// *  Cobre: casas decimais 0 - 3, valores negativos e grandes, buffer cheio (amostra mais antiga    *
+// *  perdida), rebase após SB_REBASE, pacotes menores que as amostras (restante no próximo),        *
+// *  envio com falha (sem commit: mesmo conteúdo no próximo pacote) e drop().                       *
+// *                                                                                                 *
+// *  Saída: "F <horário> <hex>" seguido de "S <id> <horário> <valor x 10^casas> <casas>" por        *
+// *  amostra e "E" no fim do pacote. Retorno 1 se o próprio codificador divergir do modelo.         *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+#include "SampleBatch.h"
+
+#define RINGS           4
+#define RING_SIZE       6
+
+struct Model
+{
+  byte id, decimals;
+  std::deque<sb_sample> q;      // Amostras esperadas (horário absoluto em time_abs)
+  std::deque<unsigned long> t;
+};
+
+int main(int argc, char **argv)
+{
+  unsigned seed = argc > 1 ? (unsigned)atoi(argv[1]) : 1;
+  int frames = argc > 2 ? atoi(argv[2]) : 2000;
+  std::mt19937 rng(seed);
+  int errors = 0;
+
+  sb_sample buf[RINGS][RING_SIZE];
+  SampleRing r0(1, 0, buf[0], RING_SIZE), r1(2, 1, buf[1], RING_SIZE);
+  SampleRing r2(3, 2, buf[2], RING_SIZE), r3(63, 3, buf[3], RING_SIZE);
+  SampleRing *rings[RINGS] = { &r0, &r1, &r2, &r3 };
+  Model m[RINGS] = { { 1, 0, {}, {} }, { 2, 1, {}, {} }, { 3, 2, {}, {} }, { 63, 3, {}, {} } };
+
+  unsigned long now = 1000000;
+  for (int f = 0; f < frames; f++) {
+    // Novas amostras (às vezes um salto maior que SB_REBASE)
+    int adds = (int)(rng() % 8);
+    for (int a = 0; a < adds; a++) {
+      now += (rng() % 50 == 0) ? SB_REBASE + rng() % 1000 : rng() % 300;
+      int i = (int)(rng() % RINGS);
+      long v;
+      switch (rng() % 3) {
+        case 0: v = (long)(rng() % 200) - 100; break;
+        case 1: v = (long)(rng() % 2000001) - 1000000; break;
+        default: v = (long)(rng() % 4294967295u) - 2147483647L; break;
+      }
+      rings[i]->addRaw(v, now);
+
+      // Modelo: rebase descarta o que ficou a mais de SB_REBASE, buffer cheio descarta a mais antiga
+      while (!m[i].t.empty() && now - m[i].t.front() > SB_REBASE) {
+        m[i].q.pop_front();
+        m[i].t.pop_front();
+      }
+      if (m[i].q.size() == RING_SIZE) {
+        m[i].q.pop_front();
+        m[i].t.pop_front();
+      }
+      m[i].q.push_back({ v, 0 });
+      m[i].t.push_back(now);
+    }
+
+    // Pacote de tamanho variável (pode não caber tudo)
+    now += rng() % 30;
+    byte out[255], counts[RINGS];
+    uint8_t size = (uint8_t)(4 + rng() % 120);
+    uint8_t len = SampleBatch::encode(rings, RINGS, now, out, size, counts);
+
+    for (int i = 0; i < RINGS; i++) {
+      if (rings[i]->count() != m[i].q.size() || counts[i] > m[i].q.size()) {
+        printf("# anel %d: %u amostras, modelo %zu\n", i, rings[i]->count(), m[i].q.size());
+        errors++;
+      }
+    }
+    if (len > size) {
+      printf("# pacote de %u bytes em buffer de %u\n", len, size);
+      errors++;
+    }
+    if (len == 0) continue;
+
+    printf("F %lu ", now);
+    for (uint8_t k = 0; k < len; k++) printf("%02X", out[k]);
+    printf("\n");
+    for (int i = 0; i < RINGS; i++)
+      for (byte k = 0; k < counts[i]; k++)
+        printf("S %u %lu %ld %u\n", m[i].id, m[i].t[k], m[i].q[k].value, m[i].decimals);
+    printf("E\n");
+
+    // Resultado do envio: entregue, falha (fica para o próximo) ou descartado
+    unsigned r = rng() % 10;
+    if (r < 7) {
+      SampleBatch::commit(rings, RINGS, counts);
+    } else if (r == 9) {
+      SampleBatch::drop(rings, RINGS, counts);
+    }
+    if (r < 7 || r == 9) {
+      for (int i = 0; i < RINGS; i++)
+        for (byte k = 0; k < counts[i]; k++) {
+          m[i].q.pop_front();
+          m[i].t.pop_front();
+        }
+    }
+  }
+  return errors ? 1 : 0;
+}
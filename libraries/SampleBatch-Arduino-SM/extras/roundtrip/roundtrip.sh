@@ -0,0 +1,78 @@
+#!/bin/bash
+# ***************************************************************************************************
+# *  Teste de ida e volta do SampleBatch: codificador (SampleBatch.cpp) x decode.py e decoder.js    *
+# *                                                                                                 *
+# *  Compila roundtrip.cpp no PC, decodifica cada pacote gerado com os dois decodificadores de      *
+# *  extras/ e compara id, horário e valor de cada amostra com o esperado.                          *
+# *                                                                                                 *
+# *  Requisitos: g++, python3 e node                                                                *
+# *  Uso: extras/roundtrip/roundtrip.sh [semente] [pacotes]                                         *
+# *  Retorno: 0 se os dois decodificadores reproduzem todas as amostras, 1 caso contrário           *
+# ***************************************************************************************************
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+LIB=$(cd "$DIR/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+g++ -O2 -std=c++11 -I"$DIR" -I"$LIB/src" -o "$WORK/roundtrip" \
+    "$DIR/roundtrip.cpp" "$LIB/src/SampleBatch.cpp" || exit 1
+"$WORK/roundtrip" "${1:-1}" "${2:-2000}" > "$WORK/frames.txt" || {
+  grep '^#' "$WORK/frames.txt"
+  echo "FALHOU (codificador)"
+  exit 1
+}
+
+# Decodificação com decoder.js: uma linha "id horário valor" por amostra, "E" no fim do pacote
+node -e '
+  var sb = require(process.argv[1]);
+  var lines = require("fs").readFileSync(process.argv[2], "utf8").split("\n");
+  var out = [];
+  lines.forEach(function (l) {
+    var p = l.split(" ");
+    if (p[0] !== "F") return;
+    var r = sb.decodeBatch(sb.hexToBytes(p[2]), new Date(Number(p[1]) * 1000));
+    if (r.errors) { out.push("erro " + r.errors[0]); return; }
+    r.variables.forEach(function (v) {
+      v.samples.forEach(function (s) { out.push(v.id + " " + s.time.getTime() / 1000 + " " + s.value); });
+    });
+    out.push("E");
+  });
+  require("fs").writeFileSync(process.argv[3], out.join("\n") + "\n");
+' "$LIB/extras/decoder.js" "$WORK/frames.txt" "$WORK/js.txt" || exit 1
+
+python3 - "$LIB/extras" "$WORK/frames.txt" "$WORK/js.txt" <<'PY'
+import sys
+sys.path.insert(0, sys.argv[1])
+from decode import decode_batch
+
+frames = []
+for line in open(sys.argv[2]):
+    p = line.split()
+    if p[0] == "F":
+        frames.append((int(p[1]), bytes.fromhex(p[2]), []))
+    elif p[0] == "S":
+        frames[-1][2].append((int(p[1]), int(p[2]), int(p[3]), int(p[4])))
+
+js = [l.split() for l in open(sys.argv[3]).read().split("E\n")]
+errors = 0
+samples = 0
+for n, (now, data, expected) in enumerate(frames):
+    exp = [(i, t, v / 10 ** d, v, d) for i, t, v, d in expected]
+    py = [(vid, t, v) for vid, s in decode_batch(data, now) for t, v in s]
+    words = js[n]
+    jsv = [(int(words[k]), float(words[k + 1]), float(words[k + 2])) for k in range(0, len(words), 3)]
+    for name, got in (("decode.py", py), ("decoder.js", jsv)):
+        ok = len(got) == len(exp) and all(
+            g[0] == e[0] and g[1] == e[1] and round(g[2] * 10 ** e[4]) == e[3]
+            for g, e in zip(got, exp))
+        if not ok:
+            errors += 1
+            if errors <= 5:
+                print("%s: pacote %d (%s) diferente do esperado" % (name, n, data.hex().upper()))
+    samples += len(exp)
+
+print("%d pacotes, %d amostras, %d divergencia(s)" % (len(frames), samples, errors))
+print("FALHOU" if errors else "OK")
+sys.exit(1 if errors else 0)
+PY
@@ -0,0 +1,225 @@
+//==========================================================================
+// A library to accumulate timestamped sensor samples and send them
+// in batches as a compact delta-encoded frame.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+//==========================================================================
+
+#include "Arduino.h"
+#include "SampleBatch.h"
+
+//==========================================================================
+SampleRing::SampleRing(byte id, byte decimals, sb_sample* buf, byte size)
+{
+  if (decimals > 3) decimals = 3;
+  _id = (decimals << 6) | (id & 0x3F);
+  for (byte i=0; i<decimals; i++)
+    _scale *= 10;
+  _buf = buf;
+  _size = size;
+}
+
+//==========================================================================
+void SampleRing::add(float value, unsigned long time)
+{
+  value *= _scale;
+  addRaw((long)(value < 0 ? value - 0.5 : value + 0.5), time);
+}
+
+//==========================================================================
+void SampleRing::addRaw(long value, unsigned long time)
+{
+  byte idx;
+
+  if (_count == 0)
+  {
+    _base = time;
+  }
+  else if (time - _base > SB_REBASE)
+  {
+    rebase(time);
+  }
+
+  if (_count < _size)
+  {
+    idx = (_head + _count) % _size;
+    _count++;
+  }
+  else
+  {
+    // Ring full: overwrite the oldest sample
+    idx = _head;
+    _head = (_head + 1) % _size;
+    if (_lost < 255) _lost++;
+  }
+
+  _buf[idx].value = value;
+  _buf[idx].time = (uint16_t)(time - _base);
+}
+
+//==========================================================================
+void SampleRing::rebase(unsigned long time)
+{
+  // Drop samples too old to be represented from the new base
+  while (_count > 0 && time - (_base + _buf[_head].time) > SB_REBASE)
+  {
+    _head = (_head + 1) % _size;
+    _count--;
+    if (_lost < 255) _lost++;
+  }
+
+  if (_count == 0)
+  {
+    _base = time;
+    return;
+  }
+
+  // Move the base to the oldest sample
+  uint16_t shift = _buf[_head].time;
+  for (byte i=0; i<_count; i++)
+  {
+    _buf[(_head + i) % _size].time -= shift;
+  }
+  _base += shift;
+}
+
+//==========================================================================
+byte SampleRing::count(void)
+{
+  return _count;
+}
+
+//==========================================================================
+byte SampleRing::lost(void)
+{
+  byte n = _lost;
+  _lost = 0;
+  return n;
+}
+
+//==========================================================================
+void SampleRing::clear(void)
+{
+  _head = 0;
+  _count = 0;
+}
+
+//==========================================================================
+uint8_t SampleRing::encode(byte* out, uint8_t size, unsigned long now, byte* count)
+{
+  uint8_t pos = 2;
+  uint8_t len;
+  byte n = 1;
+  byte tmp[10];
+
+  *count = 0;
+  if (_count == 0 || size < 2) return 0;
+
+  // Block header: id, number of samples, base value and age of the oldest sample
+  sb_sample* s = &_buf[_head];
+  unsigned long t = _base + s->time;
+  out[0] = _id;
+
+  len = SampleBatch::putSVarint(out + pos, size - pos, s->value);
+  if (len == 0) return 0;
+  pos += len;
+  len = SampleBatch::putVarint(out + pos, size - pos, now > t ? now - t : 0);
+  if (len == 0) return 0;
+  pos += len;
+
+  // Deltas of time and value from the previous sample
+  long prevValue = s->value;
+  uint16_t prevTime = s->time;
+  for (; n<_count; n++)
+  {
+    s = &_buf[(_head + n) % _size];
+    len = SampleBatch::putVarint(tmp, sizeof(tmp), s->time - prevTime);
+    len += SampleBatch::putSVarint(tmp + len, sizeof(tmp) - len, s->value - prevValue);
+    if (pos + len > size) break;
+    memcpy(out + pos, tmp, len);
+    pos += len;
+    prevValue = s->value;
+    prevTime = s->time;
+  }
+  out[1] = n;
+
+  // The samples stay in the ring until the frame is delivered (commit())
+  *count = n;
+  return pos;
+}
+
+//==========================================================================
+void SampleRing::commit(byte n)
+{
+  if (n > _count) n = _count;
+  _head = (_head + n) % _size;
+  _count -= n;
+}
+
+//==========================================================================
+void SampleRing::drop(byte n)
+{
+  if (n > _count) n = _count;
+  commit(n);
+  _lost = (_lost + n > 255) ? 255 : _lost + n;
+}
+
+//==========================================================================
+uint8_t SampleBatch::encode(SampleRing* const* rings, byte n, unsigned long now, byte* out, uint8_t size,
+                            byte* counts)
+{
+  uint8_t pos = 1;
+
+  for (byte i=0; i<n; i++)
+    counts[i] = 0;
+  if (size < 1) return 0;
+  out[0] = SB_FORMAT;
+
+  for (byte i=0; i<n; i++)
+  {
+    pos += rings[i]->encode(out + pos, size - pos, now, &counts[i]);
+  }
+
+  // Only the format byte: nothing to send
+  if (pos == 1) return 0;
+  return pos;
+}
+
+//==========================================================================
+void SampleBatch::commit(SampleRing* const* rings, byte n, const byte* counts)
+{
+  for (byte i=0; i<n; i++)
+    rings[i]->commit(counts[i]);
+}
+
+//==========================================================================
+void SampleBatch::drop(SampleRing* const* rings, byte n, const byte* counts)
+{
+  for (byte i=0; i<n; i++)
+    rings[i]->drop(counts[i]);
+}
+
+//==========================================================================
+uint8_t SampleBatch::putVarint(byte* out, uint8_t size, unsigned long v)
+{
+  uint8_t n = 0;
+  do
+  {
+    if (n >= size) return 0;
+    byte b = v & 0x7F;
+    v >>= 7;
+    if (v) b |= 0x80;
+    out[n++] = b;
+  } while (v);
+  return n;
+}
+
+//==========================================================================
+uint8_t SampleBatch::putSVarint(byte* out, uint8_t size, long v)
+{
+  // Zigzag: small negative and positive deltas both use few bytes
+  unsigned long z = ((unsigned long)v << 1) ^ (v < 0 ? ~0UL : 0UL);
+  return putVarint(out, size, z);
+}
@@ -0,0 +1,145 @@
+//==========================================================================
+// A library to accumulate timestamped sensor samples and send them
+// in batches as a compact delta-encoded frame.
+//
+// Author - David Souza - SmartMosaic - Brasil
+// version 1.0 - out/26
+//
+// Frame format (all integers are LEB128 varints, signed values zigzag):
+//
+//   byte    SB_FORMAT (0x01)
+//   per variable:
+//     byte    (decimals << 6) | id         decimals 0 - 3, id 0 - 63
+//     byte    n                            number of samples
+//     svarint value[0]                     oldest value x 10^decimals
+//     varint  age                          seconds from value[0] to the frame
+//     n-1 x   varint dt, svarint dv        seconds and value since previous
+//
+// Decoders: extras/decoder.js (network server) and extras/decode.py.
+// Round trip check of the encoder and both decoders: extras/roundtrip.
+//
+// Sending is done in two steps: encode() builds the frame and leaves the
+// samples in the rings; commit() removes them once the frame was delivered
+// (a failed send keeps them for the next frame). No sample may be added
+// between encode() and commit().
+//
+//==========================================================================
+
+#ifndef SampleBatch_h
+#define	SampleBatch_h
+
+#include "Arduino.h"
+
+// Version of the frame format (first byte of the frame)
+#define SB_FORMAT       0x01
+// Span (s) of the stored time offsets before the ring is rebased
+#define SB_REBASE       60000
+
+// One stored sample: scaled value and time offset (s) from the ring base
+typedef struct sb_sample
+{
+  long value;
+  uint16_t time;
+} sb_sample;
+
+class SampleRing
+{
+  public:
+
+    // =================================================================================================
+    // Ring of samples of one variable using storage given by the caller.
+	// id = variable id sent in the frame (0 - 63)
+	// decimals = decimal places kept from the float value (0 - 3)
+	// buf / size = sample storage (the oldest sample is overwritten when full)
+    // =================================================================================================
+    SampleRing(byte id, byte decimals, sb_sample* buf, byte size);
+
+    // =================================================================================================
+    // Store a sample. time = sample time in seconds (any monotonic clock).
+    // =================================================================================================
+    void add(float value, unsigned long time);
+
+    // =================================================================================================
+    // Store a sample already scaled by 10^decimals.
+    // =================================================================================================
+    void addRaw(long value, unsigned long time);
+
+    // =================================================================================================
+    // Number of samples waiting to be sent.
+    // =================================================================================================
+    byte count(void);
+
+    // =================================================================================================
+    // Number of samples overwritten because the ring was full (since the last call).
+    // =================================================================================================
+    byte lost(void);
+
+    // =================================================================================================
+    // Discard all samples.
+    // =================================================================================================
+    void clear(void);
+
+    // =================================================================================================
+    // Append the oldest samples to a frame without removing them from the ring.
+    // Returns the number of bytes written (0 = nothing fits).
+	// now = frame time in seconds (same clock as add())
+	// count = number of samples written (to be given to commit() or drop())
+    // =================================================================================================
+    uint8_t encode(byte* out, uint8_t size, unsigned long now, byte* count);
+
+    // =================================================================================================
+    // Remove the n oldest samples (sent by the last encode()).
+    // =================================================================================================
+    void commit(byte n);
+
+    // =================================================================================================
+    // Same as commit() for samples that will never be delivered: they are counted in lost().
+    // =================================================================================================
+    void drop(byte n);
+
+  private:
+
+    sb_sample* _buf;			// Sample storage
+    byte _size;					// Capacity of _buf
+    byte _head = 0;				// Index of the oldest sample
+    byte _count = 0;			// Number of stored samples
+    byte _lost = 0;				// Overwritten samples
+    byte _id;					// Variable id and decimals (first byte of the block)
+    long _scale = 1;			// 10^decimals
+    unsigned long _base = 0;	// Time (s) of offset 0
+
+    void rebase(unsigned long time);
+};
+
+class SampleBatch
+{
+  public:
+
+    // =================================================================================================
+    // Build a frame with the samples of the rings. Returns the frame size in bytes, or 0 if
+    // there is nothing to send. All the samples stay in the rings until commit().
+	// rings / n = rings to send
+	// now = frame time in seconds (same clock as SampleRing::add())
+	// counts = samples written per ring (n bytes), given back to commit() / drop()
+    // =================================================================================================
+    static uint8_t encode(SampleRing* const* rings, byte n, unsigned long now, byte* out, uint8_t size,
+                          byte* counts);
+
+    // =================================================================================================
+    // Remove from the rings the samples of a frame that was delivered.
+    // =================================================================================================
+    static void commit(SampleRing* const* rings, byte n, const byte* counts);
+
+    // =================================================================================================
+    // Remove from the rings the samples of a frame that will never be delivered (counted in lost()).
+    // =================================================================================================
+    static void drop(SampleRing* const* rings, byte n, const byte* counts);
+
+    // =================================================================================================
+    // Varint helpers. Return the number of bytes written (0 = no space).
+    // =================================================================================================
+    static uint8_t putVarint(byte* out, uint8_t size, unsigned long v);
+    static uint8_t putSVarint(byte* out, uint8_t size, long v);
+};
+
+#endif
@@ -0,0 +1,39 @@
+// ***************************************************************************************************
+// *  Benchmark no AVR: conversão do LM35 e texto em ponto fixo (FixedPoint-Arduino-SM)              *
+// *                                                                                                 *
+// *  Imprime na serial (57600) os ciclos por leitura. Compare com FixBenchFloat; a flash dos dois   *
+// *  sketches é comparada por tools/fixbench/compare.sh                                             *
+// *                                                                                                 *
+// *  Desenvolvido por David Souza - SmartMosaic - smartmosaic.com.br                                *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+#include <FixedPoint.h>
+
+#define N_READS       1000      // Leituras medidas
+
+volatile uint16_t raw;          // Leitura simulada (volatile para não ser otimizada)
+
+void setup(void)
+{
+  char buf[FP_TEXT];
+  Serial.begin(57600);
+
+  unsigned long t0 = micros();
+  for (uint16_t i = 0; i < N_READS; i++) {
+    raw = i;
+    long temperature = FixedPoint::lm35(raw, 1024);   // Centésimos de °C
+    FixedPoint::format(buf, sizeof(buf), temperature, 2);
+  }
+  unsigned long t = micros() - t0;
+
+  Serial.print(F("ponto fixo: "));
+  Serial.print(buf);
+  Serial.print(F(" / "));
+  Serial.print(t * 16 / N_READS);               // 16 ciclos por us a 16 MHz
+  Serial.println(F(" ciclos por leitura"));
+}
+
+void loop(void)
+{
+}
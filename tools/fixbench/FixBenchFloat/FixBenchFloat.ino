@@ -0,0 +1,38 @@
+// ***************************************************************************************************
+// *  Benchmark no AVR: conversão do LM35 e texto com float (caminho original dos exemplos)          *
+// *                                                                                                 *
+// *  Imprime na serial (57600) os ciclos por leitura. Compare com FixBenchFixed; a flash dos dois   *
+// *  sketches é comparada por tools/fixbench/compare.sh                                             *
+// *                                                                                                 *
+// *  Desenvolvido por David Souza - SmartMosaic - smartmosaic.com.br                                *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+#define N_READS       1000      // Leituras medidas
+
+volatile uint16_t raw;          // Leitura simulada (volatile para não ser otimizada)
+
+void setup(void)
+{
+  char buf[16];
+  Serial.begin(57600);
+
+  unsigned long t0 = micros();
+  for (uint16_t i = 0; i < N_READS; i++) {
+    raw = i;
+    float temperature = (float(raw) * 5 / (1023)) / 0.01;
+    dtostrf(temperature, 4, 2, buf);            // Mesma formatação de String(float)
+  }
+  unsigned long t = micros() - t0;
+
+  Serial.print(F("float: "));
+  Serial.print(buf);
+  Serial.print(F(" / "));
+  Serial.print(t * 16 / N_READS);               // 16 ciclos por us a 16 MHz
+  Serial.println(F(" ciclos por leitura"));
+}
+
+void loop(void)
+{
+}
@@ -0,0 +1,34 @@
+#!/bin/bash
+# ***************************************************************************************************
+# *  Comparação da flash no AVR: ponto fixo (FixBenchFixed) x float (FixBenchFloat)                 *
+# *                                                                                                 *
+# *  Compila os dois sketches com tools/footprint/footprint.sh e falha se FixBenchFixed não         *
+# *  ocupar menos flash que FixBenchFloat (o float e o dtostrf deixam de ser ligados).              *
+# *                                                                                                 *
+# *  Requisitos: os mesmos de footprint.sh (arduino-cli com o core arduino:avr, avr-size)           *
+# *                                                                                                 *
+# *  Uso: tools/fixbench/compare.sh                                                                 *
+# *  Retorno: 0 se o ponto fixo ocupa menos flash, 1 caso contrário ou em erro de compilação        *
+# ***************************************************************************************************
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+
+out=$("$ROOT/tools/footprint/footprint.sh" "$ROOT/tools/fixbench/budget.txt")
+status=$?
+echo "$out"
+
+float=$(echo "$out" | awk '$1=="FixBenchFloat"{print $3}')
+fixed=$(echo "$out" | awk '$1=="FixBenchFixed"{print $3}')
+case "$float$fixed" in
+  ''|*[!0-9]*)
+    echo "Flash não medida (erro de compilação)"
+    exit 1 ;;
+esac
+
+echo
+echo "Flash: float $float bytes, ponto fixo $fixed bytes ($((fixed - float)) bytes)"
+if [ "$fixed" -ge "$float" ]; then
+  echo "FALHOU: o ponto fixo não ocupa menos flash que o float"
+  exit 1
+fi
+exit $status
@@ -0,0 +1,188 @@
+// ***************************************************************************************************
+// *  Benchmark da conversão e formatação em ponto fixo (FixedPoint-Arduino-SM) x float              *
+// *                                                                                                 *
+// *  Compara, para todas as leituras possíveis:                                                     *
+// *    - LM35: (float)raw * 500 / fundo de escala + texto com 2 casas (como String(float))          *
+// *            x FixedPoint::lm35() + FixedPoint::format()                                          *
+// *    - DHT22: bits -> float / 10 + texto x FixedPoint::dht22() + FixedPoint::format()             *
+// *  e mede o tempo de cada caminho no PC.                                                          *
+// *                                                                                                 *
+// *  O PC tem FPU: a diferença de tempo aqui é muito menor que no AVR, onde o float é emulado.      *
+// *  Ciclos e flash no AVR: sketches FixBenchFloat e FixBenchFixed desta pasta                      *
+// *    - Ciclos: grave o sketch e veja a serial (57600)                                             *
+// *    - Flash:  tools/fixbench/compare.sh (falha se o ponto fixo não ocupar menos flash)           *
+// *                                                                                                 *
+// *  Compilação (Linux, na raiz do repositório):                                                    *
+// *    g++ -O2 -std=c++11 -Itools/fixbench/host -Ilibraries/FixedPoint-Arduino-SM/src \             *
+// *        -o fixbench tools/fixbench/fixbench.cpp libraries/FixedPoint-Arduino-SM/src/FixedPoint.cpp *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "FixedPoint.h"
+
+typedef std::chrono::steady_clock clk;
+
+// Evita que o compilador descarte os resultados
+static volatile unsigned sink;
+
+// ***************************************************************************************************
+// *  Caminho float (como nos exemplos)                                                              *
+// ***************************************************************************************************
+static float lm35_float(unsigned raw, unsigned full)
+{
+  return (float(raw) * 5 / full) / 0.01;
+}
+
+// String(float) usa dtostrf(valor, 4, 2): mesmo resultado de "%.2f"
+static int format_float(char *out, size_t size, float v)
+{
+  return snprintf(out, size, "%.2f", v);
+}
+
+// SimpleDHT22::read2: bits -> inteiros -> float / 10
+static void dht22_float(const byte *bits, float *t, float *h)
+{
+  unsigned hum = 0, tem = 0;
+  for (int i = 0; i < 16; i++) hum |= (unsigned)bits[i] << (15 - i);
+  for (int i = 0; i < 16; i++) tem |= (unsigned)bits[16 + i] << (15 - i);
+  *h = hum / 10.0f;
+  *t = (tem & 0x8000) ? -(float)(tem & 0x7FFF) / 10.0f : (float)tem / 10.0f;
+}
+
+static void dht22_bits(byte *bits, unsigned hum, int tem)
+{
+  unsigned t = tem < 0 ? (0x8000 | (unsigned)-tem) : (unsigned)tem;
+  byte d[5] = { (byte)(hum >> 8), (byte)hum, (byte)(t >> 8), (byte)t, 0 };
+  d[4] = (byte)(d[0] + d[1] + d[2] + d[3]);
+  for (int i = 0; i < 40; i++) bits[i] = (d[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+// ***************************************************************************************************
+// *  Equivalência dos dois caminhos                                                                 *
+// ***************************************************************************************************
+static int check(void)
+{
+  char a[FP_TEXT], b[FP_TEXT];
+  int errors = 0;
+
+  // LM35: todas as leituras de 10 bits (analogRead) e de 12 bits (AdcScan)
+  const unsigned fulls[] = { 1024, 4096 };
+  for (unsigned full : fulls) {
+    long differ = 0, maxdiff = 0;
+    for (unsigned raw = 0; raw < full; raw++) {
+      format_float(a, sizeof(a), lm35_float(raw, full));
+      long fx = FixedPoint::lm35((uint16_t)raw, (uint16_t)full);
+      FixedPoint::format(b, sizeof(b), fx, 2);
+      if (strcmp(a, b) != 0) {
+        long d = labs(lround(atof(a) * 100) - fx);
+        differ++;
+        if (d > maxdiff) maxdiff = d;
+      }
+    }
+    printf("LM35 %4u: %5u leituras, %ld textos diferentes (arredondamento do float), "
+           "maior diferenca %ld centesimo(s)\n", full, full, differ, maxdiff);
+    if (maxdiff > 1) errors++;
+  }
+
+  // DHT22: toda a faixa do sensor (-40.0 a 80.0 °C, 0.0 a 100.0 %)
+  byte bits[40];
+  long differ = 0;
+  for (int t = -400; t <= 800; t++) {
+    for (unsigned h = 0; h <= 1000; h += 7) {
+      float ft, fh;
+      int it, ih;
+      dht22_bits(bits, h, t);
+      dht22_float(bits, &ft, &fh);
+      if (!FixedPoint::dht22(bits, &it, &ih)) { errors++; continue; }
+      format_float(a, sizeof(a), ft);
+      FixedPoint::format(b, sizeof(b), it * 10L, 2);
+      if (strcmp(a, b) != 0) differ++;
+      format_float(a, sizeof(a), fh);
+      FixedPoint::format(b, sizeof(b), ih * 10L, 2);
+      if (strcmp(a, b) != 0) differ++;
+    }
+  }
+  printf("DHT22: %ld textos diferentes\n", differ);
+  if (differ) errors++;
+
+  // Checksum inválido é rejeitado
+  dht22_bits(bits, 500, 250);
+  bits[39] ^= 1;
+  if (FixedPoint::dht22(bits, NULL, NULL)) errors++;
+
+  // Formatação de extremos
+  const struct { long v; byte d; const char *txt; } cases[] = {
+    { 0, 2, "0.00" }, { -5, 2, "-0.05" }, { 2534, 2, "25.34" }, { -2534, 1, "-253.4" },
+    { 7, 0, "7" }, { 2147483647L, 2, "21474836.47" }, { -2147483647L - 1, 0, "-2147483648" },
+  };
+  for (auto &c : cases) {
+    FixedPoint::format(b, sizeof(b), c.v, c.d);
+    if (strcmp(b, c.txt) != 0) {
+      printf("format(%ld, %u) = \"%s\", esperado \"%s\"\n", c.v, c.d, b, c.txt);
+      errors++;
+    }
+  }
+  if (FixedPoint::format(b, 5, 12345, 2) != 0 || b[0] != '\0') errors++;
+  if (FixedPoint::rescale(2535, 2, 1) != 254 || FixedPoint::rescale(-2535, 2, 1) != -254 ||
+      FixedPoint::rescale(25, 1, 2) != 250) errors++;
+
+  return errors;
+}
+
+// ***************************************************************************************************
+// *  Tempo dos dois caminhos                                                                        *
+// ***************************************************************************************************
+static double ns_per_op(clk::time_point t0, long ops)
+{
+  return std::chrono::duration<double, std::nano>(clk::now() - t0).count() / ops;
+}
+
+static void bench(int rounds)
+{
+  char buf[FP_TEXT];
+  long ops = (long)rounds * 4096;
+
+  clk::time_point t0 = clk::now();
+  for (int r = 0; r < rounds; r++)
+    for (unsigned raw = 0; raw < 4096; raw++) {
+      format_float(buf, sizeof(buf), lm35_float(raw, 4096));
+      sink += (unsigned)buf[0];
+    }
+  double f = ns_per_op(t0, ops);
+
+  t0 = clk::now();
+  for (int r = 0; r < rounds; r++)
+    for (unsigned raw = 0; raw < 4096; raw++) {
+      FixedPoint::format(buf, sizeof(buf), FixedPoint::lm35((uint16_t)raw, 4096), 2);
+      sink += (unsigned)buf[0];
+    }
+  double x = ns_per_op(t0, ops);
+
+  printf("\nLM35 + texto (PC, %ld leituras): float %.1f ns, ponto fixo %.1f ns (%.1fx)\n",
+         ops, f, x, f / x);
+}
+
+// ***************************************************************************************************
+// *  Função principal                                                                               *
+// ***************************************************************************************************
+int main(int argc, char **argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 200;
+  if (rounds < 1) {
+    printf("uso: fixbench [rodadas]\n");
+    return 1;
+  }
+
+  int errors = check();
+  bench(rounds);
+  printf("%s\n", errors ? "FALHOU" : "OK");
+  return errors ? 1 : 0;
+}
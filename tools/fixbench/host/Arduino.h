@@ -0,0 +1,11 @@
+// ***************************************************************************************************
+// *  Substituto mínimo do Arduino.h para compilar FixedPoint.cpp no PC (tools/fixbench)             *
+// ***************************************************************************************************
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+
+typedef uint8_t byte;
+
+#endif
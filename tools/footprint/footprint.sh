@@ -0,0 +1,113 @@
+#!/bin/bash
+# ***************************************************************************************************
+# *  Relatório de uso de memória (flash e RAM) dos exemplos                                         *
+# *                                                                                                 *
+# *  Compila cada exemplo de budget.txt com arduino-cli e compara com o orçamento:                  *
+# *    - Flash: .text + .data                                                                       *
+# *    - RAM estática: .data + .bss                                                                 *
+# *    - Livre: SRAM da placa - RAM estática (pilha + heap disponíveis)                             *
+# *                                                                                                 *
+# *  O pico de heap depende da execução (Strings alocadas em tempo de execução) e não é             *
+# *  obtido pela compilação; a coluna "Livre" é o limite que ele não pode ultrapassar. Os           *
+# *  exemplos imprimem a RAM mínima medida em execução (biblioteca FreeRam-Arduino-SM).             *
+# *                                                                                                 *
+# *  Limite "-" no orçamento: o valor não é comparado com um limite fixo.                           *
+# *                                                                                                 *
+# *  Base (<orçamento>.base, ex.: budget.base): flash e RAM estática medidas de cada exemplo.       *
+# *  Com --update a medição é gravada como nova base. Sem --update, um exemplo que cresce em        *
+# *  relação à base falha (Status CRESCEU) e um exemplo sem base é só mostrado (Status NOVO).       *
+# *  Assim o uso de memória é acompanhado sem números digitados à mão.                              *
+# *                                                                                                 *
+# *  Requisitos: arduino-cli com o core arduino:avr e as bibliotecas dos exemplos instaladas        *
+# *              (WeeESP8266, SimpleDHT, PubSubClient, Ethernet), avr-size no PATH.                 *
+# *                                                                                                 *
+# *  Uso: tools/footprint/footprint.sh [--update] [budget.txt]                                      *
+# *  Retorno: 0 se todos os exemplos estão dentro do orçamento e da base, 1 caso contrário          *
+# ***************************************************************************************************
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+UPDATE=0
+[ "$1" = "--update" ] && { UPDATE=1; shift; }
+BUDGET=${1:-$ROOT/tools/footprint/budget.txt}
+BASE=${BUDGET%.txt}.base
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# SRAM de cada placa (bytes)
+sram() {
+  case $1 in
+    arduino:avr:mega*) echo 8192 ;;
+    *)                 echo 2048 ;;
+  esac
+}
+
+# Variação em relação à base ("-" sem base)
+delta() {
+  [ -n "$2" ] && printf "%+d" $(($1 - $2)) || echo "-"
+}
+
+status=0
+errors=0
+: > "$WORK/base"
+printf "%-16s %-18s %8s %8s %7s %8s %8s %7s %8s  %s\n" \
+       "Exemplo" "Placa" "Flash" "Máx" "Base" "RAM" "Máx" "Base" "Livre" "Status"
+
+while read -r name dir fqbn flash_max ram_max; do
+  # Ignora comentários e linhas vazias
+  case $name in ''|\#*) continue ;; esac
+
+  # Copia o sketch para compilar sem alterar a árvore (chaves.h é opcional nos exemplos)
+  sk=$WORK/$(basename "$dir")
+  cp -r "$ROOT/$dir" "$sk"
+  [ -f "$sk/chaves.h" ] || : > "$sk/chaves.h"
+
+  build=$WORK/build-$name
+  if ! arduino-cli compile --fqbn "$fqbn" --libraries "$ROOT/libraries" \
+         --build-path "$build" "$sk" > "$WORK/$name.log" 2>&1; then
+    printf "%-16s %-18s %8s %8s %7s %8s %8s %7s %8s  %s\n" \
+           "$name" "$fqbn" "-" "$flash_max" "-" "-" "$ram_max" "-" "-" "ERRO"
+    errors=1
+    sed 's/^/    /' "$WORK/$name.log" | tail -20
+    status=1
+    continue
+  fi
+
+  # Tamanho das seções do ELF
+  elf=$(ls "$build"/*.elf | head -1)
+  read -r text data bss <<< "$(avr-size -A "$elf" | \
+    awk '$1==".text"{t=$2} $1==".data"{d=$2} $1==".bss"{b=$2} END{print t+0, d+0, b+0}')"
+  flash=$((text + data))
+  ram=$((data + bss))
+  free=$(( $(sram "$fqbn") - ram ))
+
+  echo "$name $flash $ram" >> "$WORK/base"
+  read -r base_flash base_ram <<< "$(awk -v n="$name" '$1==n{print $2, $3}' "$BASE" 2>/dev/null)"
+
+  result=OK
+  if [ $UPDATE -eq 0 ] && [ -z "$base_flash" ]; then
+    result=NOVO
+  elif [ $UPDATE -eq 0 ] && { [ "$flash" -gt "$base_flash" ] || [ "$ram" -gt "$base_ram" ]; }; then
+    result=CRESCEU
+    status=1
+  fi
+  if { [ "$flash_max" != "-" ] && [ "$flash" -gt "$flash_max" ]; } ||
+     { [ "$ram_max" != "-" ] && [ "$ram" -gt "$ram_max" ]; }; then
+    result=ESTOURO
+    status=1
+  fi
+  printf "%-16s %-18s %8d %8s %7s %8d %8s %7s %8d  %s\n" \
+         "$name" "$fqbn" "$flash" "$flash_max" "$(delta "$flash" "$base_flash")" \
+         "$ram" "$ram_max" "$(delta "$ram" "$base_ram")" "$free" "$result"
+done < "$BUDGET"
+
+# Grava a nova base só se todos os exemplos compilaram
+if [ $UPDATE -eq 1 ]; then
+  if [ $errors -eq 0 ]; then
+    cp "$WORK/base" "$BASE"
+    echo "Base gravada em $BASE"
+  else
+    echo "Base não gravada: há exemplos com erro de compilação"
+  fi
+fi
+
+exit $status
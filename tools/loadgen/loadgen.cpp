@@ -0,0 +1,745 @@
+// ***************************************************************************************************
+// *  Gerador de carga para o backend de ingestão (ProIoT)                                           *
+// *                                                                                                 *
+// *  Simula N nodes enviando dados com o mesmo formato dos exemplos:                                *
+// *    - HTTP: requisição montada como em send_TCP() (Sensores-HTTP-WeeESP8266)                     *
+// *    - HTTP em lote: pacote SampleBatch em hexadecimal no alias BATCH_ALIAS, como send_batch()    *
+// *    - MQTT: CONNECT/PUBLISH como em mqtt.ino (PubSubClient, tópico device/<id>, mensagem "ok")   *
+// *                                                                                                 *
+// *  Por padrão sobe localmente um substituto do endpoint HTTP da ProIoT                            *
+// *  (/stream/device/<node>/variable/<alias>/<valor>) e um broker MQTT mínimo, e mede:              *
+// *  requisições por segundo, percentis de latência e conexões abertas por segundo.                 *
+// *                                                                                                 *
+// *  Compilação (Linux):                                                                            *
+// *    g++ -O2 -std=c++11 -pthread -o loadgen loadgen.cpp                                           *
+// *                                                                                                 *
+// *  Exemplos:                                                                                      *
+// *    ./loadgen --nodes 200 --interval 10000 --duration 30                                         *
+// *    ./loadgen --nodes 200 --keepalive --batch                                                    *
+// *    ./loadgen --mode mqtt --nodes 500 --interval 2000 --qos 1                                    *
+// *    ./loadgen --sweep                 (matriz keep-alive x lote x intervalo)                     *
+// *    ./loadgen --no-server --host 192.168.0.10 --port 8080   (backend externo)                    *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ***************************************************************************************************
+// *  Definições do formato dos exemplos                                                             *
+// ***************************************************************************************************
+#define HOST_NAME     "things.proiot.network"   // Cabeçalho Host enviado pelos sketches
+#define TOKEN         "SEU_TOKEN"
+#define VAL_MIN       0                         // Faixa do valor simulado (como VAL_MIN/VAL_MAX)
+#define VAL_MAX       40
+#define MQTT_KEEPALIVE 15                       // Keep-alive padrão do PubSubClient (s)
+#define MQTT_PAYLOAD  "ok"                      // Mensagem publicada pelo mqtt.ino
+#define BATCH_ALIAS   "10"                      // Alias do pacote em lote (Sensores-HTTP)
+
+typedef std::chrono::steady_clock clk;
+
+// ***************************************************************************************************
+// *  Parâmetros da execução                                                                         *
+// ***************************************************************************************************
+struct Options
+{
+  std::string mode = "http";    // http ou mqtt
+  std::string host = "127.0.0.1";
+  int port = 0;                 // 0 = porta livre escolhida pelo servidor local
+  bool server = true;           // Sobe o substituto local da ProIoT
+  int nodes = 100;              // Número de nodes simulados
+  int interval = 10000;         // Intervalo entre relatórios de cada node (ms)
+  int duration = 20;            // Duração da medição (s)
+  int vars = 3;                 // Variáveis por relatório (TEMP, HUMI, TEMP2)
+  bool keepalive = false;       // Mantém a conexão entre relatórios
+  bool batch = false;           // Envia todas as variáveis em um só pacote/publicação
+  int qos = 0;                  // QoS do MQTT (1 = mede latência pelo PUBACK)
+  bool sweep = false;           // Executa a matriz de cenários
+};
+
+// ***************************************************************************************************
+// *  Resultado de uma execução                                                                      *
+// ***************************************************************************************************
+struct Result
+{
+  std::vector<double> lat;      // Latências (ms)
+  long requests = 0;            // Requisições/publicações concluídas
+  long connects = 0;            // Conexões abertas
+  long errors = 0;              // Falhas (conexão, envio ou resposta)
+
+  void merge(const Result &o)
+  {
+    lat.insert(lat.end(), o.lat.begin(), o.lat.end());
+    requests += o.requests;
+    connects += o.connects;
+    errors += o.errors;
+  }
+};
+
+// Contadores do servidor local
+static std::atomic<long> srv_requests(0);
+static std::atomic<long> srv_accepts(0);
+static std::atomic<long> srv_bad(0);
+
+// ***************************************************************************************************
+// *  Funções auxiliares de socket                                                                   *
+// ***************************************************************************************************
+static bool write_all(int fd, const char *buf, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+static int tcp_connect(const std::string &host, int port)
+{
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+    struct hostent *he = gethostbyname(host.c_str());
+    if (he == NULL) return -1;
+    memcpy(&addr.sin_addr, he->h_addr_list[0], sizeof(addr.sin_addr));
+  }
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  struct timeval tv = { 5, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int tcp_listen(int *port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((uint16_t)*port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 1024) < 0) {
+    perror("listen");
+    exit(1);
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(fd, (struct sockaddr *)&addr, &len);
+  *port = ntohs(addr.sin_port);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+// ***************************************************************************************************
+// *  Substituto local da ProIoT (HTTP)                                                              *
+// ***************************************************************************************************
+// Aceita POST /stream/device/<node>/variable/<alias>/<valor>: um valor ou, no alias
+// BATCH_ALIAS, o pacote em lote em hexadecimal.
+// Trata conexões persistentes e ignora as linhas vazias extras que os sketches enviam após o
+// cabeçalho ("\r\n\r\n" adicional em send_TCP()).
+static int http_handle(std::string &in, std::string &out)
+{
+  int handled = 0;
+  for (;;) {
+    // Linhas vazias entre requisições
+    size_t skip = 0;
+    while (skip < in.size() && (in[skip] == '\r' || in[skip] == '\n')) skip++;
+    in.erase(0, skip);
+
+    size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos) break;
+
+    size_t body_len = 0;
+    size_t cl = in.find("Content-Length:");
+    if (cl != std::string::npos && cl < end) body_len = (size_t)atol(in.c_str() + cl + 15);
+    if (in.size() < end + 4 + body_len) break;
+
+    std::string line = in.substr(0, in.find("\r\n"));
+    bool ok = line.compare(0, 20, "POST /stream/device/") == 0 &&
+              line.find("/variable/") != std::string::npos;
+    if (ok) {
+      srv_requests++;
+      out += "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}";
+    } else {
+      srv_bad++;
+      out += "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    }
+    in.erase(0, end + 4 + body_len);
+    handled++;
+  }
+  return handled;
+}
+
+// ***************************************************************************************************
+// *  Substituto local do broker MQTT (3.1.1, somente o necessário para o PubSubClient)              *
+// ***************************************************************************************************
+static int mqtt_handle(std::string &in, std::string &out, bool *close_conn)
+{
+  int handled = 0;
+  for (;;) {
+    if (in.size() < 2) break;
+
+    // Comprimento restante (codificação variável)
+    size_t rem = 0, pos = 1;
+    int shift = 0;
+    for (;;) {
+      if (pos >= in.size()) return handled;
+      unsigned char b = (unsigned char)in[pos++];
+      rem |= (size_t)(b & 0x7F) << shift;
+      shift += 7;
+      if (!(b & 0x80)) break;
+    }
+    if (in.size() < pos + rem) break;
+
+    unsigned char type = (unsigned char)in[0] >> 4;
+    unsigned char flags = (unsigned char)in[0] & 0x0F;
+    switch (type) {
+      case 1:   // CONNECT -> CONNACK
+        out.append("\x20\x02\x00\x00", 4);
+        break;
+      case 3: { // PUBLISH
+        srv_requests++;
+        int qos = (flags >> 1) & 0x03;
+        if (qos > 0) {
+          size_t tlen = ((unsigned char)in[pos] << 8) | (unsigned char)in[pos + 1];
+          size_t id = pos + 2 + tlen;
+          char ack[4] = { 0x40, 0x02, in[id], in[id + 1] };
+          out.append(ack, 4);
+        }
+        break;
+      }
+      case 12:  // PINGREQ -> PINGRESP
+        out.append("\xD0\x00", 2);
+        break;
+      case 14:  // DISCONNECT
+        *close_conn = true;
+        break;
+      default:
+        srv_bad++;
+        break;
+    }
+    in.erase(0, pos + rem);
+    handled++;
+  }
+  return handled;
+}
+
+// ***************************************************************************************************
+// *  Laço do servidor local (epoll, uma thread)                                                     *
+// ***************************************************************************************************
+static std::atomic<bool> srv_stop(false);
+
+static void server_loop(int lfd, bool mqtt)
+{
+  int ep = epoll_create1(0);
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.fd = lfd;
+  epoll_ctl(ep, EPOLL_CTL_ADD, lfd, &ev);
+
+  std::vector<std::string> inbuf(65536);
+  struct epoll_event events[256];
+  char buf[4096];
+
+  while (!srv_stop) {
+    int n = epoll_wait(ep, events, 256, 100);
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+      if (fd == lfd) {
+        int c;
+        while ((c = accept(lfd, NULL, NULL)) >= 0) {
+          if (c >= (int)inbuf.size()) inbuf.resize(c * 2);
+          int one = 1;
+          setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          fcntl(c, F_SETFL, O_NONBLOCK);
+          ev.events = EPOLLIN;
+          ev.data.fd = c;
+          epoll_ctl(ep, EPOLL_CTL_ADD, c, &ev);
+          inbuf[c].clear();
+          srv_accepts++;
+        }
+        continue;
+      }
+
+      bool close_conn = false;
+      ssize_t r;
+      while ((r = recv(fd, buf, sizeof(buf), 0)) > 0) inbuf[fd].append(buf, (size_t)r);
+      if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) close_conn = true;
+
+      std::string out;
+      if (mqtt) {
+        mqtt_handle(inbuf[fd], out, &close_conn);
+      } else {
+        http_handle(inbuf[fd], out);
+      }
+      if (!out.empty()) {
+        // Respostas pequenas: escrita bloqueante curta é suficiente
+        int fl = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, fl & ~O_NONBLOCK);
+        if (!write_all(fd, out.data(), out.size())) close_conn = true;
+        fcntl(fd, F_SETFL, fl);
+      }
+      if (close_conn) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        inbuf[fd].clear();
+      }
+    }
+  }
+  close(ep);
+}
+
+// ***************************************************************************************************
+// *  Montagem das mensagens (mesmo formato dos sketches)                                            *
+// ***************************************************************************************************
+// Valor formatado como String(float) do Arduino: 2 casas decimais
+static std::string fmt_value(double v)
+{
+  char b[32];
+  snprintf(b, sizeof(b), "%.2f", v);
+  return b;
+}
+
+// Alias das variáveis: "01", "02", "03", ...
+static std::string alias_of(int i)
+{
+  char b[16];
+  snprintf(b, sizeof(b), "%02d", i + 1);
+  return b;
+}
+
+// Igual a send_TCP(): note o "\r\n\r\n" extra após o fim do cabeçalho
+static std::string http_single(const std::string &node, const std::string &alias, double v)
+{
+  std::string d = "POST ";
+  d += "/stream/device/";
+  d += node;
+  d += "/variable/";
+  d += alias;
+  d += "/";
+  d += fmt_value(v);
+  d += " HTTP/1.1\r\n";
+  d += "Host: ";
+  d += HOST_NAME;
+  d += "\r\n";
+  d += "Authorization: ";
+  d += TOKEN;
+  d += "\r\n";
+  d += "\r\n\r\n";
+  return d;
+}
+
+// Varint LEB128 do formato SampleBatch
+static void put_varint(std::string &out, unsigned long v)
+{
+  do {
+    unsigned char b = v & 0x7F;
+    v >>= 7;
+    if (v) b |= 0x80;
+    out += (char)b;
+  } while (v);
+}
+
+// Lote: igual a send_batch(), um pacote SampleBatch (uma amostra por variável, 2 casas)
+// enviado em hexadecimal como valor do alias BATCH_ALIAS
+static std::string http_batch(const std::string &node, const std::vector<double> &v)
+{
+  std::string frame(1, (char)0x01);                       // SB_FORMAT
+  for (size_t i = 0; i < v.size(); i++) {
+    long x = lround(v[i] * 100);
+    frame += (char)((2 << 6) | (i & 0x3F));               // 2 casas, id
+    frame += (char)1;                                     // 1 amostra
+    put_varint(frame, ((unsigned long)x << 1) ^ (x < 0 ? ~0UL : 0UL));
+    put_varint(frame, 0);                                 // Idade (s)
+  }
+  std::string hex;
+  char b[3];
+  for (unsigned char c : frame) {
+    snprintf(b, sizeof(b), "%02X", c);
+    hex += b;
+  }
+  std::string d = "POST ";
+  d += "/stream/device/";
+  d += node;
+  d += "/variable/";
+  d += BATCH_ALIAS;
+  d += "/";
+  d += hex;
+  d += " HTTP/1.1\r\n";
+  d += "Host: ";
+  d += HOST_NAME;
+  d += "\r\n";
+  d += "Authorization: ";
+  d += TOKEN;
+  d += "\r\n";
+  d += "\r\n\r\n";
+  return d;
+}
+
+// Lê uma resposta HTTP completa (cabeçalho + Content-Length)
+static bool http_read_response(int fd, std::string &pending)
+{
+  char buf[1024];
+  for (;;) {
+    size_t end = pending.find("\r\n\r\n");
+    if (end != std::string::npos) {
+      size_t body = 0;
+      size_t cl = pending.find("Content-Length:");
+      if (cl != std::string::npos && cl < end) body = (size_t)atol(pending.c_str() + cl + 15);
+      if (pending.size() >= end + 4 + body) {
+        bool ok = pending.compare(0, 12, "HTTP/1.1 200") == 0;
+        pending.erase(0, end + 4 + body);
+        return ok;
+      }
+    }
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    pending.append(buf, (size_t)n);
+  }
+}
+
+// Codificação MQTT
+static void mqtt_remlen(std::string &p, size_t len)
+{
+  do {
+    unsigned char b = len % 128;
+    len /= 128;
+    if (len) b |= 0x80;
+    p += (char)b;
+  } while (len);
+}
+
+static void mqtt_str(std::string &p, const std::string &s)
+{
+  p += (char)(s.size() >> 8);
+  p += (char)(s.size() & 0xFF);
+  p += s;
+}
+
+// Igual a reconnect() do mqtt.ino: clientId "proiot-dev-<hex>", usuário = token, senha vazia
+static std::string mqtt_connect_pkt(const std::string &client_id)
+{
+  std::string v;
+  mqtt_str(v, "MQTT");
+  v += (char)4;                 // Nível do protocolo (3.1.1)
+  v += (char)0xC2;              // Usuário + senha + sessão limpa
+  v += (char)(MQTT_KEEPALIVE >> 8);
+  v += (char)(MQTT_KEEPALIVE & 0xFF);
+  mqtt_str(v, client_id);
+  mqtt_str(v, TOKEN);
+  mqtt_str(v, "");
+  std::string p(1, (char)0x10);
+  mqtt_remlen(p, v.size());
+  return p + v;
+}
+
+static std::string mqtt_publish_pkt(const std::string &topic, const std::string &payload,
+                                    int qos, uint16_t id)
+{
+  std::string v;
+  mqtt_str(v, topic);
+  if (qos > 0) {
+    v += (char)(id >> 8);
+    v += (char)(id & 0xFF);
+  }
+  v += payload;
+  std::string p(1, (char)(0x30 | (qos << 1)));
+  mqtt_remlen(p, v.size());
+  return p + v;
+}
+
+static bool read_exact(int fd, char *buf, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = recv(fd, buf, len, 0);
+    if (n <= 0) return false;
+    buf += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// ***************************************************************************************************
+// *  Node simulado                                                                                  *
+// ***************************************************************************************************
+static double ms_since(clk::time_point t0)
+{
+  return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+static void node_http(const Options &o, int id, clk::time_point stop, Result *res)
+{
+  std::mt19937 rng((unsigned)id * 7919u + 1);
+  std::uniform_real_distribution<double> val(VAL_MIN, VAL_MAX);
+  std::string node = "node" + std::to_string(id);
+
+  // Fase aleatória para não sincronizar todos os nodes
+  clk::time_point next = clk::now() + std::chrono::milliseconds(rng() % (unsigned)o.interval);
+  int fd = -1;
+  std::string pending;
+
+  while (next < stop) {
+    std::this_thread::sleep_until(next);
+    next += std::chrono::milliseconds(o.interval);
+
+    std::vector<double> v((size_t)o.vars);
+    for (auto &x : v) x = val(rng);
+
+    std::vector<std::string> reqs;
+    if (o.batch) {
+      reqs.push_back(http_batch(node, v));
+    } else {
+      for (int i = 0; i < o.vars; i++) reqs.push_back(http_single(node, alias_of(i), v[(size_t)i]));
+    }
+
+    for (const std::string &r : reqs) {
+      clk::time_point t0 = clk::now();
+      if (fd < 0) {
+        fd = tcp_connect(o.host, o.port);
+        if (fd < 0) {
+          res->errors++;
+          continue;
+        }
+        res->connects++;
+        pending.clear();
+      }
+      bool ok = write_all(fd, r.data(), r.size()) && http_read_response(fd, pending);
+      if (ok) {
+        res->requests++;
+        res->lat.push_back(ms_since(t0));
+      } else {
+        res->errors++;
+      }
+      // Sem keep-alive: uma conexão por requisição, como createTCP()/releaseTCP()
+      if (!ok || !o.keepalive) {
+        close(fd);
+        fd = -1;
+      }
+    }
+  }
+  if (fd >= 0) close(fd);
+}
+
+static void node_mqtt(const Options &o, int id, clk::time_point stop, Result *res)
+{
+  std::mt19937 rng((unsigned)id * 7919u + 1);
+  char cid[32];
+  snprintf(cid, sizeof(cid), "proiot-dev-%x", (unsigned)(rng() & 0xFFFF));
+  std::string topic = "device/node" + std::to_string(id);
+
+  clk::time_point next = clk::now() + std::chrono::milliseconds(rng() % (unsigned)o.interval);
+  int fd = -1;
+  uint16_t pkt_id = 1;
+
+  while (next < stop) {
+    std::this_thread::sleep_until(next);
+    next += std::chrono::milliseconds(o.interval);
+
+    // Mesma mensagem do mqtt.ino: uma publicação por variável ou uma só em lote
+    std::vector<std::string> payloads((size_t)(o.batch ? 1 : o.vars), MQTT_PAYLOAD);
+
+    for (size_t i = 0; i < payloads.size(); i++) {
+      clk::time_point t0 = clk::now();
+      if (fd < 0) {
+        fd = tcp_connect(o.host, o.port);
+        char ack[4];
+        std::string c = mqtt_connect_pkt(cid);
+        if (fd < 0 || !write_all(fd, c.data(), c.size()) || !read_exact(fd, ack, 4) ||
+            ack[0] != 0x20 || ack[3] != 0) {
+          if (fd >= 0) close(fd);
+          fd = -1;
+          res->errors++;
+          continue;
+        }
+        res->connects++;
+      }
+      // Mesmo tópico do mqtt.ino (device/<id>) para envio único ou em lote
+      std::string p = mqtt_publish_pkt(topic, payloads[i], o.qos, pkt_id);
+      bool ok = write_all(fd, p.data(), p.size());
+      if (ok && o.qos > 0) {
+        char ack[4];
+        ok = read_exact(fd, ack, 4) && (unsigned char)ack[0] == 0x40 &&
+             (((unsigned char)ack[2] << 8) | (unsigned char)ack[3]) == pkt_id;
+      }
+      pkt_id = (uint16_t)(pkt_id == 0xFFFF ? 1 : pkt_id + 1);
+      if (ok) {
+        res->requests++;
+        res->lat.push_back(ms_since(t0));
+      } else {
+        res->errors++;
+      }
+      if (!ok || !o.keepalive) {
+        if (ok) write_all(fd, "\xE0\x00", 2);     // DISCONNECT
+        close(fd);
+        fd = -1;
+      }
+    }
+  }
+  if (fd >= 0) {
+    write_all(fd, "\xE0\x00", 2);
+    close(fd);
+  }
+}
+
+// ***************************************************************************************************
+// *  Execução de um cenário                                                                         *
+// ***************************************************************************************************
+static double percentile(std::vector<double> &v, double p)
+{
+  if (v.empty()) return 0;
+  size_t k = (size_t)(p / 100.0 * (double)(v.size() - 1) + 0.5);
+  std::nth_element(v.begin(), v.begin() + (long)k, v.end());
+  return v[k];
+}
+
+static void print_header(void)
+{
+  printf("%-5s %6s %8s %4s %5s %5s | %9s %9s %8s %8s %8s %8s %7s\n",
+         "modo", "nodes", "interv", "vars", "keep", "lote",
+         "req/s", "conex/s", "p50(ms)", "p90(ms)", "p99(ms)", "max(ms)", "erros");
+}
+
+static void run(const Options &o)
+{
+  clk::time_point start = clk::now();
+  clk::time_point stop = start + std::chrono::seconds(o.duration);
+  long srv_req0 = srv_requests, srv_acc0 = srv_accepts, srv_bad0 = srv_bad;
+
+  std::vector<Result> res((size_t)o.nodes);
+  std::vector<std::thread> th;
+  for (int i = 0; i < o.nodes; i++) {
+    if (o.mode == "mqtt") {
+      th.emplace_back(node_mqtt, std::cref(o), i, stop, &res[(size_t)i]);
+    } else {
+      th.emplace_back(node_http, std::cref(o), i, stop, &res[(size_t)i]);
+    }
+  }
+  for (auto &t : th) t.join();
+
+  Result all;
+  for (auto &r : res) all.merge(r);
+  double secs = std::chrono::duration<double>(clk::now() - start).count();
+
+  double lmax = all.lat.empty() ? 0 : *std::max_element(all.lat.begin(), all.lat.end());
+  printf("%-5s %6d %8d %4d %5s %5s | %9.1f %9.1f %8.2f %8.2f %8.2f %8.2f %7ld\n",
+         o.mode.c_str(), o.nodes, o.interval, o.vars, o.keepalive ? "sim" : "nao",
+         o.batch ? "sim" : "nao", all.requests / secs, all.connects / secs,
+         percentile(all.lat, 50), percentile(all.lat, 90), percentile(all.lat, 99), lmax,
+         all.errors);
+  if (o.server) {
+    printf("      servidor local: %ld requisicoes, %ld conexoes aceitas, %ld invalidas\n",
+           srv_requests - srv_req0, srv_accepts - srv_acc0, srv_bad - srv_bad0);
+  }
+  if (o.mode == "mqtt" && o.qos == 0) {
+    printf("      (QoS 0: latencia = tempo de escrita no socket; use --qos 1 para ida e volta)\n");
+  }
+  fflush(stdout);
+}
+
+// ***************************************************************************************************
+// *  Função principal                                                                               *
+// ***************************************************************************************************
+static void usage(void)
+{
+  printf("uso: loadgen [--mode http|mqtt] [--nodes N] [--interval ms] [--duration s]\n"
+         "               [--vars K] [--keepalive] [--batch] [--qos 0|1] [--sweep]\n"
+         "               [--no-server --host H --port P]\n");
+}
+
+int main(int argc, char **argv)
+{
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    auto next = [&](void) -> const char * {
+      if (i + 1 >= argc) { usage(); exit(1); }
+      return argv[++i];
+    };
+    if (a == "--mode") o.mode = next();
+    else if (a == "--host") o.host = next();
+    else if (a == "--port") o.port = atoi(next());
+    else if (a == "--no-server") o.server = false;
+    else if (a == "--nodes") o.nodes = atoi(next());
+    else if (a == "--interval") o.interval = atoi(next());
+    else if (a == "--duration") o.duration = atoi(next());
+    else if (a == "--vars") o.vars = atoi(next());
+    else if (a == "--keepalive") o.keepalive = true;
+    else if (a == "--batch") o.batch = true;
+    else if (a == "--qos") o.qos = atoi(next());
+    else if (a == "--sweep") o.sweep = true;
+    else { usage(); return 1; }
+  }
+  if ((o.mode != "http" && o.mode != "mqtt") || o.nodes < 1 || o.interval < 1 || o.vars < 1) {
+    usage();
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  std::thread srv;
+  if (o.server) {
+    int lfd = tcp_listen(&o.port);
+    srv = std::thread(server_loop, lfd, o.mode == "mqtt");
+    printf("Substituto local (%s) em 127.0.0.1:%d\n", o.mode.c_str(), o.port);
+  }
+
+  print_header();
+  if (o.sweep) {
+    const int intervals[] = { 1000, 5000, 10000 };
+    for (int iv : intervals) {
+      for (int keep = 0; keep < 2; keep++) {
+        for (int batch = 0; batch < 2; batch++) {
+          Options s = o;
+          s.interval = iv;
+          s.keepalive = keep != 0;
+          s.batch = batch != 0;
+          run(s);
+        }
+      }
+    }
+  } else {
+    run(o);
+  }
+
+  if (o.server) {
+    srv_stop = true;
+    srv.join();
+  }
+  return 0;
+}
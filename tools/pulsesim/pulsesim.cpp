@@ -0,0 +1,287 @@
+// ***************************************************************************************************
+// *  Simulador do contador de pulsos por interrupção (PulseCounter-Arduino-SM)                      *
+// *                                                                                                 *
+// *  Simula no PC a entrada do contador de um AVR de 16 MHz e estima a maior taxa de pulsos         *
+// *  contada sem erro. Modelo:                                                                      *
+// *    - A interrupção externa guarda só 1 borda pendente: uma segunda borda que chega com as       *
+// *      interrupções desligadas (ou durante outra ISR) é perdida                                   *
+// *    - INT0..INT5 têm prioridade sobre as demais interrupções, mas não interrompem uma ISR         *
+// *    - ISRs de fundo: Timer0 (millis), Timer2 (agendador), ADC (AdcScan) e serial                 *
+// *    - SoftwareSerial desliga as interrupções durante cada byte enviado ou recebido                *
+// *    - O debounce usa micros() (resolução de 4 us) lido dentro da ISR                             *
+// *                                                                                                 *
+// *  Compilação (Linux):                                                                            *
+// *    g++ -O2 -std=c++11 -o pulsesim pulsesim.cpp                                                  *
+// *                                                                                                 *
+// *  Exemplos:                                                                                      *
+// *    ./pulsesim                          (taxa máxima exata por cenário e debounce)               *
+// *    ./pulsesim --rate 150 --bounce 4    (detalhe de uma taxa, com 4 repiques por pulso)          *
+// *    ./pulsesim --baud 19200 --debounce 500                                                       *
+// *                                                                                                 *
+// *  Versão 1.0 - Outubro/2026                                                                      *
+// *                                                                                                 *
+// ***************************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// ***************************************************************************************************
+// *  Tempos do AVR a 16 MHz (us)                                                                    *
+// ***************************************************************************************************
+#define ISR_COUNTER_US  9.0     // attachInterrupt + micros() + PulseCounter::handleInterrupt (~145 ciclos)
+#define ISR_STAMP_US    4.5     // Da entrada na ISR até a leitura de micros()
+#define MICROS_RES_US   4.0     // Resolução de micros() (Timer0 com prescaler 64)
+#define T0_PERIOD_US    1024.0  // Estouro do Timer0 (millis)
+#define T0_ISR_US       5.0
+#define T2_PERIOD_US    8000.0  // Estouro do Timer2 (T2_TICK_MS)
+#define T2_ISR_US       6.0
+#define ADC_DELAY_US    104.0   // Fim da conversão do AdcScan após o estouro do Timer0
+#define ADC_ISR_US      6.0
+#define HWSERIAL_ISR_US 5.0     // ISR de recepção da serial por hardware (Serial1 do Mega)
+#define SOFT_GAP_US     8.0     // Intervalo com interrupções ligadas entre bytes da SoftwareSerial
+
+// ***************************************************************************************************
+// *  Parâmetros da execução                                                                         *
+// ***************************************************************************************************
+struct Options
+{
+  double rate = 0;              // Taxa de pulsos (Hz). 0 = procura a taxa máxima
+  double debounce = -1;         // Debounce (us). -1 = 0 e o valor do exemplo (DEB_CT = 5 ms)
+  double jitter = 10;           // Variação aleatória do período dos pulsos (%)
+  int bounce = 0;               // Repiques (bordas extras) após cada pulso
+  double bounce_us = 50;        // Intervalo entre repiques (us)
+  double duration = 2;          // Tempo simulado por taxa (s)
+  double isr = ISR_COUNTER_US;  // Duração da ISR do contador (us)
+  int baud = 9600;              // Velocidade da SoftwareSerial
+  unsigned seed = 1;
+};
+
+// ***************************************************************************************************
+// *  Cenário: janelas em que a ISR do contador não pode ser atendida                                *
+// ***************************************************************************************************
+struct Scenario
+{
+  const char *name;
+  bool soft;                    // Tráfego pela SoftwareSerial (UNO)
+  bool traffic;                 // Comunicação contínua com o RN2903
+};
+
+struct Window
+{
+  double start, end;
+};
+
+// Janelas periódicas de uma ISR de fundo
+static void add_periodic(std::vector<Window> &w, double period, double phase, double len,
+                         double total)
+{
+  for (double t = phase; t < total; t += period) w.push_back({ t, t + len });
+}
+
+// Comunicação contínua: comando de 40 bytes seguido da resposta de 12 bytes
+static void add_traffic(std::vector<Window> &w, const Scenario &s, const Options &o, double total)
+{
+  double byte_us = 10.0 * 1e6 / (s.soft ? o.baud : 57600);
+  double t = 0;
+  while (t < total) {
+    for (int dir = 0; dir < 2; dir++) {
+      int n = dir == 0 ? 40 : 12;
+      for (int i = 0; i < n && t < total; i++) {
+        if (s.soft) {
+          // Byte inteiro com as interrupções desligadas
+          w.push_back({ t, t + byte_us });
+          t += byte_us + SOFT_GAP_US;
+        } else {
+          // Serial por hardware: só a ISR de recepção (envio por registrador)
+          if (dir == 1) w.push_back({ t + byte_us, t + byte_us + HWSERIAL_ISR_US });
+          t += byte_us;
+        }
+      }
+    }
+  }
+}
+
+// Ordena e une as janelas sobrepostas
+static void merge(std::vector<Window> &w)
+{
+  std::sort(w.begin(), w.end(), [](const Window &a, const Window &b) { return a.start < b.start; });
+  std::vector<Window> m;
+  for (const Window &x : w) {
+    if (!m.empty() && x.start <= m.back().end) m.back().end = std::max(m.back().end, x.end);
+    else m.push_back(x);
+  }
+  w.swap(m);
+}
+
+// Primeiro instante >= t fora das janelas
+static double service(const std::vector<Window> &w, double t)
+{
+  auto it = std::upper_bound(w.begin(), w.end(), t,
+                             [](double v, const Window &x) { return v < x.start; });
+  if (it != w.begin() && t < (it - 1)->end) return (it - 1)->end;
+  return t;
+}
+
+// ***************************************************************************************************
+// *  Simulação de uma taxa                                                                          *
+// ***************************************************************************************************
+struct Result
+{
+  long pulses = 0;              // Pulsos reais
+  long counted = 0;             // Pulsos contados
+  long lost = 0;                // Bordas perdidas (já havia uma pendente)
+  long rejected = 0;            // Bordas rejeitadas pelo debounce
+  double max_delay = 0;         // Maior atraso entre a borda e a ISR (us)
+};
+
+static Result simulate(const std::vector<Window> &w, const Options &o, double rate,
+                       double debounce, double total, unsigned seed)
+{
+  Result r;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> jit(-o.jitter / 100.0, o.jitter / 100.0);
+
+  // Bordas: pulsos com variação de período e repiques
+  std::vector<double> edges;
+  double period = 1e6 / rate;
+  for (double t = period * (0.5 + jit(rng)); t < total; t += period * (1.0 + jit(rng))) {
+    edges.push_back(t);
+    r.pulses++;
+    for (int b = 1; b <= o.bounce; b++) edges.push_back(t + b * o.bounce_us);
+  }
+  std::sort(edges.begin(), edges.end());
+
+  double cpu_free = 0;          // Fim da última ISR do contador
+  double last = -1e12;          // Último pulso contado (micros())
+  bool pending = false;
+  double pend_t = 0;
+
+  auto run_isr = [&](double at) {
+    double now = std::floor((at + ISR_STAMP_US) / MICROS_RES_US) * MICROS_RES_US;
+    r.max_delay = std::max(r.max_delay, at - pend_t);
+    if (now - last < debounce) {
+      r.rejected++;
+    } else {
+      last = now;
+      r.counted++;
+    }
+    cpu_free = at + o.isr;
+    pending = false;
+  };
+
+  for (double e : edges) {
+    // Atende a borda pendente se houver tempo antes desta
+    if (pending) {
+      double s = service(w, std::max(pend_t, cpu_free));
+      if (s <= e) run_isr(s);
+    }
+    if (pending) {
+      r.lost++;
+      continue;
+    }
+    pending = true;
+    pend_t = e;
+  }
+  if (pending) run_isr(service(w, std::max(pend_t, cpu_free)));
+  return r;
+}
+
+// Contagem exata nas 3 sementes
+static bool exact(const std::vector<Window> &w, const Options &o, double rate, double debounce,
+                  double total)
+{
+  for (unsigned k = 0; k < 3; k++) {
+    Result r = simulate(w, o, rate, debounce, total, o.seed + k);
+    if (r.counted != r.pulses) return false;
+  }
+  return true;
+}
+
+// ***************************************************************************************************
+// *  Função principal                                                                               *
+// ***************************************************************************************************
+static void usage(void)
+{
+  printf("uso: pulsesim [--rate Hz] [--debounce us] [--jitter %%] [--bounce N] [--bounce-us us]\n"
+         "               [--duration s] [--isr us] [--baud B] [--seed S]\n");
+}
+
+int main(int argc, char **argv)
+{
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    auto next = [&](void) -> const char * {
+      if (i + 1 >= argc) { usage(); exit(1); }
+      return argv[++i];
+    };
+    if (a == "--rate") o.rate = atof(next());
+    else if (a == "--debounce") o.debounce = atof(next());
+    else if (a == "--jitter") o.jitter = atof(next());
+    else if (a == "--bounce") o.bounce = atoi(next());
+    else if (a == "--bounce-us") o.bounce_us = atof(next());
+    else if (a == "--duration") o.duration = atof(next());
+    else if (a == "--isr") o.isr = atof(next());
+    else if (a == "--baud") o.baud = atoi(next());
+    else if (a == "--seed") o.seed = (unsigned)atoi(next());
+    else { usage(); return 1; }
+  }
+  if (o.duration <= 0 || o.isr <= 0 || o.baud <= 0 || o.jitter < 0 || o.jitter >= 100) {
+    usage();
+    return 1;
+  }
+
+  const Scenario scenarios[] = {
+    { "mega-serial1",  false, false },
+    { "mega-serial1",  false, true  },
+    { "uno-softserial", true, false },
+    { "uno-softserial", true, true  },
+  };
+  std::vector<double> debounces;
+  if (o.debounce >= 0) debounces.push_back(o.debounce);
+  else debounces = { 0, 5000 };
+
+  double total = o.duration * 1e6;
+  printf("AVR 16 MHz, ISR do contador %.1f us, variacao %.0f%%, %d repique(s), SoftwareSerial %d\n",
+         o.isr, o.jitter, o.bounce, o.baud);
+  if (o.rate > 0) {
+    printf("%-15s %7s %12s | %9s %9s %7s %9s %11s\n", "cenario", "trafego", "debounce(us)",
+           "pulsos", "contados", "perdas", "rejeit.", "atraso(us)");
+  } else {
+    printf("%-15s %7s %12s | %14s %16s\n", "cenario", "trafego", "debounce(us)",
+           "max exato(Hz)", "menor interv(us)");
+  }
+
+  for (const Scenario &s : scenarios) {
+    std::vector<Window> w;
+    add_periodic(w, T0_PERIOD_US, 0, T0_ISR_US, total);
+    add_periodic(w, T2_PERIOD_US, 300, T2_ISR_US, total);
+    add_periodic(w, T0_PERIOD_US, ADC_DELAY_US, ADC_ISR_US, total);
+    if (s.traffic) add_traffic(w, s, o, total);
+    merge(w);
+
+    for (double d : debounces) {
+      if (o.rate > 0) {
+        Result r = simulate(w, o, o.rate, d, total, o.seed);
+        printf("%-15s %7s %12.0f | %9ld %9ld %7ld %9ld %11.1f\n", s.name,
+               s.traffic ? "sim" : "nao", d, r.pulses, r.counted, r.lost, r.rejected,
+               r.max_delay);
+        continue;
+      }
+      // Sobe a taxa em passos de 2% até a primeira contagem com erro
+      double best = 0;
+      for (double f = 10; f < 1e6 / o.isr; f *= 1.02) {
+        if (!exact(w, o, f, d, total)) break;
+        best = f;
+      }
+      printf("%-15s %7s %12.0f | %14.0f %16.0f\n", s.name, s.traffic ? "sim" : "nao", d, best,
+             best > 0 ? 1e6 / best * (1.0 - o.jitter / 100.0) : 0);
+    }
+  }
+  return 0;
+}